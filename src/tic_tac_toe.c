@@ -1,12 +1,36 @@
 #include <stdio.h>
 #include <raylib.h>
 #include <raymath.h>
+#include <rlgl.h>
 #include <time.h>
 #include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <limits.h>
+#include <stddef.h>
+
+#if !defined(_WIN32)
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#if defined(__APPLE__)
+#include <mach/mach.h>
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 #define RAYGUI_IMPLEMENTATION
 #include <resources/raygui.h>
 
+#if defined(EMBED_RESOURCES)
+#include "resource_pack.h" // generated by --pack-resources, defines RESOURCE_PACK and RESOURCE_PACK_SIZE
+#endif
+
 // enum for all the different game states
 typedef enum State
 {
@@ -15,6 +39,8 @@ typedef enum State
     SETTING,
     GAMEOVER,
     PAUSE,
+    SPECTATE,
+    REPLAY,
     NONE
 } State;
 
@@ -23,7 +49,11 @@ typedef enum Gamemode
 {
     LOCAL,
     AI_MINIMAX,
-    AI_ML
+    AI_ML,
+    AI_KNN,
+    AI_TD,
+    AI_MLP,
+    AI_FOREST
 } Gamemode;
 
 // enum for all the difficulties
@@ -57,6 +87,14 @@ typedef enum Data_Result
     POSITIVE
 } Data_Result;
 
+// enum for the ways preprocess_ml_dataset() can change the dataset, duplicates are removed in every mode
+typedef enum Preprocess_Mode
+{
+    PREPROCESS_DEDUPLICATE,
+    PREPROCESS_AUGMENT,
+    PREPROCESS_CANONICAL
+} Preprocess_Mode;
+
 // struct for the storing a tile position also known as Move
 typedef struct Move
 {
@@ -76,6 +114,7 @@ typedef struct ML_Data_Row
 {
     Tile tile[9];
     Data_Result result;
+    int board_index; // base 3 encoding of the tiles of a dataset row, indexes the naive bayes prediction table and is used by kNN to merge duplicate boards
 } ML_Data_Row;
 
 // struct for storing the predicted result and score, used for comparison later
@@ -96,6 +135,17 @@ typedef struct Confusion_Matrix
     double accuracy;
 } Confusion_Matrix;
 
+// struct for storing a ROC curve and the threshold of the score with the highest accuracy
+typedef struct Roc_Curve
+{
+    float *false_positive_rates; // x of every point of the curve, from 0 to 1
+    float *true_positive_rates;  // y of every point of the curve, from 0 to 1
+    int point_count;             // number of points, one more than the number of distinct scores
+    double auc;                  // area under the curve
+    float best_threshold;        // rows with a score of at least this are predicted positive
+    double best_accuracy;        // accuracy at the best threshold
+} Roc_Curve;
+
 // definitions for UI
 #define UI_OFFSET 60                                // offset for the space at the top of the screen
 #define SCREEN_WIDTH 800                            // set the screen width
@@ -110,12 +160,541 @@ typedef struct Confusion_Matrix
 #define BACKGROUND_COLOUR (Color) { 255, 245, 225, 255 } // the background colour using a color struct
 #define TITLE_COLOUR (Color) { 117, 64, 53, 255 }   // the title colour using a color struct
 #define TITLE_FONT_SIZE 60                          // title font size
+#define FPS_CAP_OPTIONS "30 FPS;60 FPS;120 FPS;Unlimited" // options of the frame rate cap in the settings, in the same order as FPS_CAPS
+#define DEFAULT_FPS_CAP_OPTION 1                    // index of the frame rate cap that is used when the game starts, 60 FPS
+#define STATE_CHANGE_FRAMES 2                       // frames drawn without waiting for input after the state changes, so the new screen is shown
 
 // definitions for ML
-#define MAX_DATASET_SIZE 958                         // number of datasets (rows of data)
-#define MAX_DATAROW_SIZE 28                          // the max number of char in each row of data
+#define DATASET_INITIAL_CAPACITY 1024                // number of rows allocated for the dataset, doubled when it is full
+#define LEARNED_GAMES_INITIAL_CAPACITY 16            // number of finished games allocated for learning, doubled when it is full
+#define MAX_DATAROW_SIZE 32                          // the max number of char in each row of data, longer rows are rejected
 #define TRAINING_DATA_WEIGHT 0.8                     // the percentage of datasets to be used as training data
+#define NB_SMOOTHING 0.0                             // laplace smoothing added to every tile count of naive bayes, 0 for none
 #define NB_DATASET_FILE "resources/tic-tac-toe.data" // the file path for where the datasets reside
+#define BOARD_STATE_COUNT 19683                      // number of possible boards, each of the 9 cells has 3 states (3^9)
+#define PREDICT_BATCH_SIZE 256                       // number of rows scored per call to naive_bayes_predict_batch
+#define CROSS_VALIDATION_FOLDS 10                    // default number of folds for cross validation
+#define SHUFFLE_BLOCK_COUNT 64                       // number of chunks and blocks of a parallel shuffle, fixed so that the order only depends on the seed
+#define PARALLEL_SHUFFLE_THRESHOLD 65536             // datasets with fewer elements are shuffled on a single thread
+#define K_NEAREST 7                                  // number of nearest neighbours that vote on the result of a board
+#define KNN_BLOCK_SIZE 2048                          // number of training boards compared against all candidates at a time, sized to stay in the cache
+#define KNN_MAX_CANDIDATES 9                         // the max number of boards scored in one batch, one for each cell
+#define KNN_MAX_DISTANCE 18                          // the max hamming distance between two packed boards, 2 bits for each of the 9 cells
+#define MLP_INPUT_SIZE 27                            // one-hot input of the network, 3 tile states for each of the 9 cells
+#define MLP_HIDDEN_SIZE 32                           // number of hidden units of the network, a multiple of 8 so that AVX2 can compute 8 at a time
+#define MLP_BATCH_SIZE 16                            // number of rows in each mini-batch of SGD
+#define MLP_EPOCH_COUNT 400                          // number of passes over the training rows
+#define MLP_LEARNING_RATE 0.1f                       // size of each SGD step
+#define MLP_TASK_COUNT 4                             // number of shards trained in parallel every epoch, fixed so that the model only depends on the seed
+#define FOREST_TREE_COUNT 32                         // number of decision trees in the random forest
+#define FOREST_MAX_DEPTH 9                           // max depth of a tree, a path never splits on the same cell twice
+#define FOREST_MIN_SPLIT 4                           // nodes with fewer rows than this become leaves
+#define FOREST_FEATURE_COUNT 5                       // number of random cells that are tried at every split
+#define MLP_QUANTIZED_BIAS_LIMIT 31000               // limit of a quantized hidden bias, so that adding 9 int8 weights still fits in a short
+#define MLP_CALIBRATION_REPEATS 50                   // number of times the calibration scores every possible board to time the kernels
+#define NB_QUANTIZATION_SCALE 256.0                  // value of 1 in a quantized naive bayes log probability, so a step is 1/256 of a nat
+#define NB_QUANTIZED_LOG_LIMIT 3000                  // limit of a finite quantized log probability, so that a score with an impossible tile is always lower
+
+// definitions for threading
+#define MAX_THREAD_COUNT 64                          // the max number of worker threads used for parallel work
+
+// definitions for startup
+#define STARTUP_MAX_PHASES 32                        // the max number of phases in the startup report
+// runs the statement and records how long it took as a startup phase, name must be a string literal
+#define STARTUP_CALL(name, background, ...)                       \
+    do                                                            \
+    {                                                             \
+        unsigned long long startup_start_ns = get_monotonic_ns(); \
+        __VA_ARGS__;                                              \
+        record_startup_phase(name, startup_start_ns, background); \
+    } while (0)
+
+// definitions for the performance HUD
+#define PERF_HUD_KEY KEY_F3                          // key that shows and hides the performance HUD during a game
+#define PERF_HUD_WIDTH 340                           // size of the HUD panel, wide enough for a 4 pixel bar for each histogram bin
+#define PERF_HUD_HEIGHT 220
+#define PERF_WINDOW_FRAMES 240                       // number of frames in the rolling window of the frame time percentiles
+#define PERF_HISTOGRAM_BINS 65                       // number of bins of the frame time histogram, one for the frames under the min time then 8 octaves
+#define PERF_HISTOGRAM_MIN_TIME 1.0f                 // milliseconds of the lower edge of the first log spaced bin
+#define PERF_HISTOGRAM_BINS_PER_OCTAVE 8             // number of bins each time the frame time doubles, so the histogram ends at 256 ms
+#define PERF_AVERAGE_WEIGHT 0.05f                    // weight of the newest frame in the moving averages of the update, render and AI time
+#define PERF_MEMORY_INTERVAL_NS 500000000ULL         // time between two reads of the memory in use
+
+// definitions for tracing
+#define TRACE_FILE "trace.json"                      // the file the trace is written to on exit or when TRACE_KEY is pressed
+#define TRACE_KEY KEY_F9                             // key that writes the trace while the game is running
+#define TRACE_BUFFER_SIZE 8192                       // number of events kept for each thread, the oldest events are overwritten
+#define TRACE_MAX_BUFFERS (MAX_THREAD_COUNT + 8)     // number of threads that can record events at the same time
+// runs the statement and records how long it took as a trace event, name must be a string literal
+#define TRACE_CALL(name, ...)                                   \
+    do                                                          \
+    {                                                           \
+        unsigned long long trace_start_ns = get_monotonic_ns(); \
+        __VA_ARGS__;                                            \
+        trace_record(name, trace_start_ns);                     \
+    } while (0)
+
+// definitions for dataset generation
+#define MAX_BOARD_SIZE 8                             // the largest board the solvers support, so that every cell fits in a 64 bit mask
+#define GENERATOR_MAX_BOARD_SIZE 4                   // the largest board the generator supports, the solver cannot label positions near the empty board of larger boards in practice
+#define GENERATOR_TASK_COUNT 64                      // number of tasks the samples are split into, fixed so that the output only depends on the seed
+#define SOLVER_TABLE_BITS 20                         // each solver has a transposition table of 2^SOLVER_TABLE_BITS entries
+
+// define values for resource pack logic
+#define RESOURCE_PACK_FILE "src/resource_pack.h"      // the default output of --pack-resources, compiled in when EMBED_RESOURCES is defined
+#define RESOURCE_PACK_MAGIC "TTRP"                   // the first 4 bytes of a decompressed resource pack
+#define RESOURCE_PACK_VERSION 1                      // version of the resource pack format
+#define RESOURCE_NAME_SIZE 64                        // max length of a packed file name, including the null character
+#define RESOURCE_ALIGNMENT 16                        // every packed file starts at a multiple of this, so the TD table can be read in place
+
+// define values for replay logic
+#define REPLAY_FILE "replays.bin"                    // the file every finished game is appended to
+#define REPLAY_MAGIC "TTRL"                          // the first 4 bytes of a replay file
+#define REPLAY_VERSION 1                             // version of the replay file format
+#define REPLAY_MAX_MOVES (ROW * COLUMN)              // a game ends after at most one move on every cell
+#define REPLAY_GAMEMODE_COUNT (AI_FOREST + 1)        // number of gamemodes a replay can be played in
+#define GAMEMODE_COUNT (AI_FOREST + 1)               // number of gamemodes, used to index the model training threads
+#define REPLAY_UNFINISHED 3                          // result of a replay that has no winner and is not a draw, after the tiles
+
+// define values for analysis logic
+#define ANALYSIS_KEY KEY_F4                          // key that shows and hides the analysis heatmap during a game
+#define ANALYSIS_TABLE_BITS 18                       // the analysis has a transposition table of 2^ANALYSIS_TABLE_BITS entries, shared by every root move
+#define ANALYSIS_FRAME_BUDGET_NS 2000000ULL          // time the analysis may search in each frame
+#define ANALYSIS_CHECK_INTERVAL 256                  // number of positions between two checks of the time budget, a power of 2
+#define ANALYSIS_WIN_VALUE 10000                     // value of a won position, plus the empty cells left so that faster wins are worth more
+#define ANALYSIS_INFINITY 32000                      // larger than any value of a position, and fits in a short
+#define ANALYSIS_BENCH_FRAMES 600                    // default number of frames of --analysis-bench, 10 seconds at 60 FPS
+
+// define values for TD learning logic
+#define TD_TABLE_FILE "resources/td-table.bin"       // the file path of the trained TD values that is mapped at startup
+#define TD_TABLE_MAGIC "TDVT"                        // the first 4 bytes of a TD table file
+#define TD_TABLE_VERSION 1                           // version of the TD table file format
+#define TD_VALUE_SCALE 32767                         // a value of 1 is saved as TD_VALUE_SCALE
+#define TD_LEARNING_RATE 0.2f                        // how far a value is moved towards the value of the next board
+#define TD_EXPLORATION_RATE 0.1                      // chance of a random move during self play
+#define TD_TASK_COUNT 16                             // number of tasks in every training round, fixed so that the table only depends on the seed
+#define TD_ROUND_GAMES 4096                          // number of games every task plays in a round before the values are averaged
+#define TD_FALLBACK_GAMES 1000000                    // number of games to train when the TD table file cannot be loaded
+
+// define values for the spectator view
+#define SPECTATOR_COLUMNS 20                         // number of mini boards in each row of the spectator view
+#define SPECTATOR_ROWS 20                            // number of rows of mini boards, SCREEN_WIDTH / SPECTATOR_COLUMNS pixels tall each
+#define SPECTATOR_GAME_COUNT (SPECTATOR_COLUMNS * SPECTATOR_ROWS) // number of games that are played at the same time
+#define SPECTATOR_BOARD_MARGIN 4                     // pixels between two mini boards
+#define SPECTATOR_MOVE_INTERVAL_NS 600000000ULL      // average time between two moves of a game, each move is delayed by 0.5 to 1.5 times this
+#define SPECTATOR_RESULT_DELAY_NS 2000000000ULL      // time a finished game stays on screen before it restarts
+#define SPECTATOR_EXPLORATION_RATE 0.2               // chance of a random move instead of the best TD move
+#define SPECTATOR_ATLAS_WIDTH 256                    // size of the spectator texture atlas, the tile texture and a white block
+#define SPECTATOR_ATLAS_HEIGHT 128
+#define SPECTATOR_CROSS_SOURCE (Rectangle){0, 0, 100, 100}   // cross in the atlas, at the same place as in the tile texture
+#define SPECTATOR_CIRCLE_SOURCE (Rectangle){100, 0, 100, 100} // circle in the atlas, at the same place as in the tile texture
+#define SPECTATOR_WHITE_SOURCE (Rectangle){204, 4, 4, 4}      // white pixels in the atlas that shapes are drawn with, with a border so that filtering stays white
+
+// enum for how the value stored in the solver's transposition table relates to the real value
+typedef enum Solver_Bound
+{
+    SOLVER_BOUND_NONE,
+    SOLVER_BOUND_EXACT,
+    SOLVER_BOUND_LOWER,
+    SOLVER_BOUND_UPPER
+} Solver_Bound;
+
+// struct for storing a board of any size up to 8x8 as one bit per cell for each tile, also known as a bitboard
+typedef struct Bitboard
+{
+    unsigned long long cross;  // bit (row * size + column) is set if the cell has a cross
+    unsigned long long circle; // bit (row * size + column) is set if the cell has a circle
+} Bitboard;
+
+// struct for an open addressing hash set of bitboards, used to remove duplicate positions
+typedef struct Bitboard_Set
+{
+    Bitboard *slots; // empty slots have every bit set in both masks, which is not a valid board
+    size_t capacity; // number of slots, always a power of 2
+    size_t count;    // number of bitboards in the set
+} Bitboard_Set;
+
+// struct for an entry of the transposition table of the solver
+typedef struct Solver_Entry
+{
+    Bitboard board;      // the position the value belongs to
+    signed char value;   // result for the player to move, 1 for a win, 0 for a draw and -1 for a loss
+    unsigned char bound; // Solver_Bound of the value
+} Solver_Entry;
+
+// struct for the winning lines of a board size and the transposition table used by solve_position
+typedef struct Board_Solver
+{
+    int size;                                             // number of rows and columns of the board
+    int cell_count;                                       // number of cells of the board
+    int line_count;                                       // number of winning lines
+    unsigned long long line_masks[2 * MAX_BOARD_SIZE + 2]; // cells of every row, column and diagonal
+    Solver_Entry *table;                                  // transposition table of previously solved positions
+    size_t table_mask;                                    // number of entries in the table - 1
+} Board_Solver;
+
+// struct for a position labeled with the result for cross
+typedef struct Labeled_Position
+{
+    Bitboard board;
+    Data_Result result;
+} Labeled_Position;
+
+// struct for the output buffer of one task of the dataset generator
+typedef struct Generator_Task
+{
+    Bitboard_Set seen;            // positions this task has already generated
+    Labeled_Position *positions;  // generated positions in the order they were found
+    int position_count;           // number of generated positions
+    int position_capacity;        // number of positions the buffer can hold
+} Generator_Task;
+
+// struct for sharing the settings and per task buffers between the tasks of the dataset generator
+typedef struct Dataset_Generator
+{
+    int board_size;                               // number of rows and columns of the boards
+    int sample_count;                             // number of random positions, or 0 to enumerate every position
+    unsigned long long seed;                      // seed of the random positions
+    Generator_Task tasks[GENERATOR_TASK_COUNT];   // output buffer of each task
+    Board_Solver solvers[MAX_THREAD_COUNT];       // solvers that are reused by the tasks, so solved positions are kept between tasks
+    int solver_in_use[MAX_THREAD_COUNT];          // whether a running task is using the solver, claimed atomically
+} Dataset_Generator;
+
+// struct for the header of a TD table file, followed by count values saved as shorts
+typedef struct Td_Table_Header
+{
+    char magic[4];  // always TD_TABLE_MAGIC
+    int version;    // always TD_TABLE_VERSION
+    int count;      // number of values, always BOARD_STATE_COUNT
+    int game_count; // number of self play games the table was trained with
+} Td_Table_Header;
+
+// struct for the header of a replay file, followed by the replay of every finished game
+typedef struct Replay_File_Header
+{
+    char magic[4]; // always REPLAY_MAGIC
+    int version;   // always REPLAY_VERSION
+} Replay_File_Header;
+
+// struct for the start of a replay, followed by move_count bytes with the cell of every move, row * COLUMN + column
+typedef struct Replay_Header
+{
+    unsigned int seed;        // seed that the ML models of the session were shuffled and trained with
+    unsigned char gamemode;   // Gamemode of the game
+    unsigned char difficulty; // DifficultyMode of the minimax AI
+    unsigned char move_count; // number of moves, cross always moves first
+    unsigned char reserved;   // always 0, keeps the header at 8 bytes
+} Replay_Header;
+
+// struct for the replay of the current game, written to the replay file once the game is finished
+typedef struct Replay
+{
+    Replay_Header header;
+    unsigned char moves[REPLAY_MAX_MOVES];
+} Replay;
+
+// struct for a replay file that is opened in the replay viewer
+typedef struct Replay_Archive
+{
+    unsigned char *data; // the whole file
+    size_t *offsets;     // offset of every replay in data
+    int count;           // number of replays
+} Replay_Archive;
+
+// struct for the statistics of a replay file
+typedef struct Replay_Stats
+{
+    long long replay_count;                           // number of replays that were read
+    long long results[REPLAY_GAMEMODE_COUNT][4];      // games of every gamemode by the winning tile, EMPTY for draws and REPLAY_UNFINISHED
+    long long move_count[REPLAY_GAMEMODE_COUNT];      // total moves of the games of every gamemode
+    long long first_move_results[ROW * COLUMN][4];    // games by the cell of the first move and their result
+} Replay_Stats;
+
+// struct for an entry of the transposition table of the analysis
+typedef struct Analysis_Entry
+{
+    Bitboard board;        // the position the value belongs to
+    short value;           // value for the player to move
+    signed char depth;     // number of moves the position was searched ahead
+    signed char best_cell; // cell of the best move, searched first the next time, -1 if the player has no move
+    unsigned char bound;   // Solver_Bound of the value
+} Analysis_Entry;
+
+// struct for the multi-PV search of the analysis heatmap, every root move is searched with iterative deepening over many frames
+typedef struct Analysis
+{
+    Board_Solver solver;                                  // winning lines of the board, the solver's own table is not allocated
+    Analysis_Entry *table;                                // transposition table shared by the searches of every root move
+    size_t table_mask;                                    // number of entries in the table - 1
+    Bitboard root;                                        // the position that is analysed
+    int depth;                                            // depth the root moves are being searched to
+    int next_cell;                                        // next cell of the root to search to depth
+    int completed_depth;                                  // depth of values, 0 until every root move has been searched once
+    bool finished;                                        // whether values are exact, the search then stops
+    short values[MAX_BOARD_SIZE * MAX_BOARD_SIZE];        // value of playing every empty cell for the player to move, searched to completed_depth
+    short pending_values[MAX_BOARD_SIZE * MAX_BOARD_SIZE]; // values of the root moves that have been searched to depth
+    unsigned long long node_count;                        // number of positions searched
+    unsigned long long deadline_ns;                       // monotonic time the current step has to stop at
+    bool aborted;                                         // whether the step ran out of time, the root move is then searched again in the next step
+} Analysis;
+
+// struct for the header of a decompressed resource pack, followed by count entries and then the data of every file
+typedef struct Resource_Pack_Header
+{
+    char magic[4]; // always RESOURCE_PACK_MAGIC
+    int version;   // always RESOURCE_PACK_VERSION
+    int count;     // number of packed files
+} Resource_Pack_Header;
+
+// struct for a file in the resource pack
+typedef struct Resource_Entry
+{
+    char name[RESOURCE_NAME_SIZE]; // file path that the game loads the file with
+    int offset;                    // offset of the data from the start of the pack
+    int size;                      // size of the data in bytes
+} Resource_Entry;
+
+// struct for sharing the values between the self play tasks of a TD training round
+typedef struct Td_Training
+{
+    const float *values;         // values at the start of the round, indexed by encode_board()
+    float *task_values;          // the copy of the values that each task learns on
+    int game_count;              // number of games every task plays
+    unsigned long long seed;     // seed of the random moves
+    int round;                   // index of the current round, so that every round has different random moves
+} Td_Training;
+
+// struct for storing a trained naive bayes model, so that several models can be trained at the same time
+typedef struct Naive_Bayes_Model
+{
+    double tile_count[9][6];                   // occurence of each tile for every cell, same columns as probability
+    double result_count[2];                    // number of negative and positive rows that are trained
+    double probability[9][6];                  // probability of each tile for every cell {Xp, Op, Bp, Xn, On, Bn}
+    double prior[2];                           // prior probability of negative p(N) and positive p(P)
+    double log_table[2][9][3];                 // log of probability indexed by [result][cell][tile], used for prediction
+    double log_prior[2];                       // log of the prior probability
+    double smoothing;                          // laplace smoothing added to every tile count, set by naive_bayes_reset
+    bool table_built;                          // whether table holds the predictions of the current probabilities
+    Predicted_Result table[BOARD_STATE_COUNT]; // prediction of every possible board indexed by encode_board(), kept last as updates do not copy it
+} Naive_Bayes_Model;
+
+// struct for storing the log probabilities of a naive bayes model in int16 fixed point, see naive_bayes_quantize()
+typedef struct Quantized_Naive_Bayes_Model
+{
+    short log_table[2][9][3]; // log_table of the model times NB_QUANTIZATION_SCALE, SHRT_MIN for a probability of 0
+    short log_prior[2];       // log_prior of the model times NB_QUANTIZATION_SCALE, kept after log_table so the AVX2 gathers stay inside the struct
+} Quantized_Naive_Bayes_Model;
+
+// struct for the state of a xoshiro256** random number generator, each user keeps its own so that it can be used in parallel
+typedef struct Random
+{
+    unsigned long long state[4];
+} Random;
+
+// struct for sharing the elements and the per chunk offsets between the tasks of a parallel shuffle
+typedef struct Parallel_Shuffle
+{
+    char *elements;                                         // the elements to shuffle
+    char *buffer;                                           // the elements sorted into their blocks
+    size_t element_size;                                    // number of bytes of each element
+    int count;                                              // number of elements
+    unsigned long long seed;                                // seed of the random blocks and of the shuffle of each block
+    bool scattering;                                        // false while counting the elements of each block, true while copying them
+    int offsets[SHUFFLE_BLOCK_COUNT][SHUFFLE_BLOCK_COUNT];  // number of elements, then the next position, of every chunk in every block
+    int block_starts[SHUFFLE_BLOCK_COUNT + 1];              // position of the first element of each block in the buffer
+} Parallel_Shuffle;
+
+// struct for storing the distinct training boards of the nearest neighbour model
+typedef struct Knn_Model
+{
+    unsigned int packed_boards[BOARD_STATE_COUNT]; // packed board of each distinct training board, see pack_board()
+    int positive_count[BOARD_STATE_COUNT];         // number of positive training rows with this board
+    int negative_count[BOARD_STATE_COUNT];         // number of negative training rows with this board
+    int count;                                     // number of distinct training boards
+} Knn_Model;
+
+// struct for storing the weights of a multilayer perceptron with one hidden layer, only contains floats so it can be used as a flat array
+typedef struct Mlp_Model
+{
+    float hidden_weights[MLP_INPUT_SIZE][MLP_HIDDEN_SIZE]; // weights from each input to each hidden unit, the input of a cell is cell * 3 + tile
+    float hidden_bias[MLP_HIDDEN_SIZE];                    // bias of each hidden unit
+    float output_weights[MLP_HIDDEN_SIZE];                 // weights from each hidden unit to the output
+    float output_bias;                                     // bias of the output, which is the win probability after a sigmoid
+} Mlp_Model;
+
+// struct for storing a multilayer perceptron with its weights quantized to 8 bit integers, see mlp_quantize()
+typedef struct Quantized_Mlp_Model
+{
+    signed char hidden_weights[MLP_INPUT_SIZE][MLP_HIDDEN_SIZE]; // hidden weights divided by hidden_scale
+    short hidden_bias[MLP_HIDDEN_SIZE];                          // hidden bias divided by hidden_scale
+    short output_weights[MLP_HIDDEN_SIZE];                       // output weights divided by output_scale, in the int8 range but stored as shorts for the multiply
+    float hidden_scale;                                          // value of 1 in the hidden layer
+    float output_scale;                                          // value of 1 in the output weights
+    float output_bias;                                           // bias of the output, kept as a float as it is added after scaling
+} Quantized_Mlp_Model;
+
+// struct for sharing the model and the training rows between the tasks of an MLP training epoch
+typedef struct Mlp_Training
+{
+    Mlp_Model *model;             // the model at the start of the epoch, replaced by the average of the task models
+    Mlp_Model *task_models;       // the copy of the model that each task trains on its shard
+    const ML_Data_Row *data_rows; // the training rows
+    int data_count;               // number of training rows
+} Mlp_Training;
+
+// struct for a node of a decision tree, the nodes of a tree are stored in one array and refer to their children by index
+typedef struct Tree_Node
+{
+    int cell;                   // cell that the node splits on, or -1 for a leaf
+    int children[3];            // index of the child for each tile of the cell, indexed by Tile
+    float positive_probability; // share of the training rows of the node that are positive, used by leaves
+} Tree_Node;
+
+// struct for storing a random forest, the nodes of every tree are stored one after another
+typedef struct Random_Forest
+{
+    Tree_Node *nodes;              // nodes of every tree
+    int roots[FOREST_TREE_COUNT];  // index of the root node of each tree
+    int node_count;                // number of nodes of all the trees
+} Random_Forest;
+
+// struct for the state of building one decision tree
+typedef struct Tree_Builder
+{
+    const ML_Data_Row *data_rows; // the training rows, referred to by index
+    Tree_Node *nodes;             // nodes of the tree
+    int node_count;               // number of nodes built so far
+    Random random;                // random generator of the bootstrap sample and of the cells tried at each split
+} Tree_Builder;
+
+// struct for sharing the training rows and the trained trees between the tasks of the forest training
+typedef struct Forest_Training
+{
+    const ML_Data_Row *data_rows;             // the training rows
+    int data_count;                           // number of training rows
+    unsigned long long seed;                  // seed of the forest, each tree uses seed + its index
+    Tree_Node *tree_nodes[FOREST_TREE_COUNT]; // nodes of each trained tree before they are copied into the forest
+    int tree_node_counts[FOREST_TREE_COUNT];  // number of nodes of each trained tree
+} Forest_Training;
+
+// enum for the models that can be evaluated by the hyperparameter sweep
+typedef enum Sweep_Model
+{
+    SWEEP_NAIVE_BAYES,
+    SWEEP_KNN,
+    SWEEP_MLP,
+    SWEEP_FOREST,
+    SWEEP_MODEL_COUNT
+} Sweep_Model;
+
+// struct for one configuration of the hyperparameter sweep and its results
+typedef struct Sweep_Config
+{
+    Sweep_Model model;                 // model that is trained
+    double training_weight;            // the percentage of the dataset used as training data, the rest is test data
+    double smoothing;                  // laplace smoothing of naive bayes, unused by the other models
+    bool multithreaded;                // whether the model trains with run_parallel itself, these configurations are ran one at a time
+    Confusion_Matrix confusion_matrix; // normalized confusion matrix on the test data
+    double training_time;              // seconds taken to train the model
+    double inference_time;             // seconds taken to predict each test row
+} Sweep_Config;
+
+// struct for sharing the dataset and the configurations between the tasks of the sweep
+typedef struct Sweep
+{
+    const ML_Data_Row *data_rows; // the shuffled dataset, only read by the tasks
+    int data_count;               // number of rows in the dataset
+    unsigned long long seed;      // seed of the models that are initialized randomly
+    Sweep_Config *configs;        // every configuration of the grid
+    int config_count;             // number of configurations
+    int *config_indices;          // index of the configuration ran by each task
+} Sweep;
+
+// struct for sharing the dataset and the results between the folds of cross validation
+typedef struct Cross_Validation
+{
+    const ML_Data_Row *data_rows;  // the dataset
+    const int *order;              // random order of the rows, so that the folds are random without moving the rows
+    int data_count;                // number of rows in the dataset
+    int fold_count;                // number of folds the dataset is split into
+    Confusion_Matrix *fold_counts; // confusion matrix counts of each fold
+} Cross_Validation;
+
+// struct for a game of the spectator view, played by the TD values on both sides
+typedef struct Spectator_Game
+{
+    Tile tile[9];                     // tiles of the board, indexed by row * 3 + column
+    Tile turn;                        // tile of the player that moves next
+    Tile winner;                      // tile of the winner, EMPTY if there is none yet or the game is a draw
+    bool finished;                    // whether the game has been won or drawn
+    unsigned long long next_event_ns; // monotonic time of the next move, or of the restart if the game is finished
+} Spectator_Game;
+
+// struct for a trace event, a named span of time on one thread
+typedef struct Trace_Event
+{
+    const char *name;               // name of the span, a string literal
+    unsigned long long start_ns;    // monotonic time the span started
+    unsigned long long duration_ns; // length of the span
+    int thread_id;                  // trace id of the thread that recorded the span
+} Trace_Event;
+
+// struct for the ring buffer of trace events of one thread, only the owning thread writes it
+typedef struct Trace_Buffer
+{
+    Trace_Event events[TRACE_BUFFER_SIZE]; // the last TRACE_BUFFER_SIZE events, event i is at i % TRACE_BUFFER_SIZE
+    unsigned long long write_count;        // number of events written so far, published with a release store after each event
+    bool owned;                            // whether a running thread writes this buffer, cleared when the thread exits
+} Trace_Buffer;
+
+// struct for a phase of the startup report
+typedef struct Startup_Phase
+{
+    const char *name;               // name of the phase, a string literal
+    unsigned long long start_ns;    // time from the start of the process to the start of the phase
+    unsigned long long duration_ns; // length of the phase
+    bool background;                // whether the phase ran on the startup loader instead of the main thread
+} Startup_Phase;
+
+// struct for the frame statistics shown by the performance HUD, fixed size so that nothing is allocated per frame
+typedef struct Perf_Stats
+{
+    float frame_times[PERF_WINDOW_FRAMES];    // milliseconds of the last frames, a ring buffer
+    int frame_index;                          // index in frame_times of the next frame
+    int frame_count;                          // number of frames in the window
+    int histogram[PERF_HISTOGRAM_BINS + 1];   // number of frames of the window in each bin, the last entry counts the frames slower than every bin
+    unsigned long long last_frame_ns;         // monotonic time the last frame started
+    unsigned long long update_ns;             // time spent in the update of the current frame, including the AI
+    unsigned long long render_ns;             // time spent drawing the current frame, not including EndDrawing()
+    unsigned long long ai_ns;                 // time spent finding AI moves in the current frame
+    float update_time, render_time, ai_time;  // moving averages in milliseconds of the last 3 times
+    int draw_calls;                           // number of draw calls of the last frame of the game
+    long long memory_bytes;                   // memory in use by the process, -1 if it cannot be read
+    unsigned long long memory_read_ns;        // monotonic time the memory was last read
+} Perf_Stats;
+
+// struct for a task that is shared between the worker threads of run_parallel
+typedef struct Parallel_Job
+{
+    void (*task)(int task_index, void *context); // function that runs a single task
+    void *context;                               // data shared by all the tasks
+    int task_count;                              // number of tasks to run
+    int next_task;                               // index of the next task to run, taken atomically by the workers
+} Parallel_Job;
+
+// struct for the worker threads that run_parallel reuses, started once and kept until the program exits
+typedef struct Parallel_Pool
+{
+    pthread_mutex_t lock;                    // protects every field below
+    pthread_cond_t job_posted;               // signalled when a job is posted for the workers
+    pthread_cond_t job_left;                 // signalled when the last worker leaves the job
+    pthread_mutex_t busy;                    // held by the thread whose job the pool is running
+    pthread_t threads[MAX_THREAD_COUNT - 1]; // the workers, the thread that posts a job is the last worker
+    int thread_count;                        // number of workers that were started
+    Parallel_Job *job;                       // job that is running, NULL when the pool is idle
+    unsigned long long job_number;           // incremented for every posted job, so that a worker joins each job at most once
+    int active_count;                        // number of workers that are running tasks of the job
+} Parallel_Pool;
 
 // function prototypes for game logic
 void init();
@@ -130,7 +709,61 @@ void set_current_state(State state);
 void handle_mouse_input();
 void change_player_turn();
 
+// function prototypes for startup logic
+void record_startup_phase(const char *name, unsigned long long start_ns, bool background);
+void *run_startup_loader(void *argument);
+void start_startup_loader();
+bool is_startup_loader_finished();
+void wait_for_startup_loader();
+void *train_knn_model(void *argument);
+void *train_mlp_model(void *argument);
+void *train_forest_model(void *argument);
+void start_model_training(Gamemode gamemode);
+bool is_model_trained(Gamemode gamemode);
+bool is_model_training();
+void join_model_training_threads();
+void load_game_assets();
+void print_startup_report();
+
+// function prototypes for resource pack logic
+unsigned char *read_whole_file(const char *file_name, size_t *size);
+void load_resource_pack();
+const unsigned char *find_packed_resource(const char *file_name, int *size);
+unsigned char *load_packed_file_data(const char *file_name, unsigned int *bytes_read);
+void load_gui_style();
+void write_resource_pack(char file_name[]);
+Image load_packed_image(const char *file_name);
+
+// function prototypes for frame pacing logic
+bool is_animating();
+void request_frames(int frame_count);
+void update_frame_pacing();
+
+// function prototypes for timing logic
+unsigned long long get_monotonic_ns();
+double get_monotonic_time();
+double get_seconds_since(unsigned long long start_ns);
+double get_thread_cpu_time();
+
+// function prototypes for performance HUD logic
+Move get_timed_ai_move(const char *name, Move (*get_best_move)());
+void record_frame_stats();
+int get_frame_time_bin(float frame_time);
+float get_frame_time_bin_edge(int bin);
+float get_frame_time_percentile(float percentile);
+int count_draw_calls();
+long long get_memory_in_use();
+void render_perf_hud();
+
+// function prototypes for tracing logic
+void release_trace_buffer(void *buffer);
+void create_trace_buffer_key();
+Trace_Buffer *acquire_trace_buffer();
+void trace_record(const char *name, unsigned long long start_ns);
+void write_trace_file(char file_name[]);
+
 // function prototypes for grid logic
+void update_board_layer();
 void render_grid();
 void render_tile(int x_coord, int y_coord, Tile tile);
 void render_text_ui();
@@ -150,12 +783,160 @@ Move get_mini_max_best_move();
 
 // function prototypes for ML logic
 void read_ml_dataset(char file_name[]);
-void shuffle_dataset();
+void read_ml_dataset_lines(char file_name[], const unsigned char data[], int size);
+bool parse_ml_data_row(char line[]);
+void report_invalid_ml_data_row(char file_name[], int row_number);
+void shuffle_dataset(Random *random);
+void stratify_dataset();
+void prepare_ml_dataset();
+void append_ml_data_row(ML_Data_Row data_row);
+ML_Data_Row transform_ml_data_row(ML_Data_Row data_row, int transform);
+ML_Data_Row canonicalize_ml_data_row(ML_Data_Row data_row);
+void append_unique_ml_data_row(Bitboard_Set *seen, ML_Data_Row data_row);
+void preprocess_ml_dataset(Preprocess_Mode mode);
+void write_ml_dataset(char file_name[]);
 void naive_bayes_learn(float training_data_weight);
+void naive_bayes_learn_row(ML_Data_Row data_row);
+void learn_finished_game();
+void apply_learned_games();
+const Naive_Bayes_Model *acquire_naive_bayes_model();
+void release_naive_bayes_model(const Naive_Bayes_Model *model);
+Naive_Bayes_Model *begin_naive_bayes_update();
+void publish_naive_bayes_update(Naive_Bayes_Model *model);
+void naive_bayes_reset(Naive_Bayes_Model *model);
+void naive_bayes_count(Naive_Bayes_Model *model, const ML_Data_Row data_rows[], const int order[], int count);
+void naive_bayes_finalize(Naive_Bayes_Model *model);
+void naive_bayes_finalize_result(Naive_Bayes_Model *model, Data_Result result);
 ML_Data_Row get_current_grid();
+int encode_board(const Tile tile[9]);
+void naive_bayes_score_moves(const Naive_Bayes_Model *model, const ML_Data_Row *data_row, Predicted_Result predicted_results[9]);
 Predicted_Result naive_bayes_predict(ML_Data_Row data_row);
+void naive_bayes_build_table(Naive_Bayes_Model *model);
+void prepare_naive_bayes_table();
+void naive_bayes_predict_rows(const void *model_data, const ML_Data_Row data_rows[], int count, Predicted_Result predicted_results[]);
+void naive_bayes_row_scores(const Naive_Bayes_Model *model, const ML_Data_Row *data_row, double scores[2]);
+void naive_bayes_predict_batch(const Naive_Bayes_Model *model, const ML_Data_Row data_rows[], int count, Predicted_Result predicted_results[]);
+void naive_bayes_quantize(const Naive_Bayes_Model *model, Quantized_Naive_Bayes_Model *quantized_model);
+void quantized_naive_bayes_predict_batch(const void *model_data, const ML_Data_Row data_rows[], int count, Predicted_Result predicted_results[]);
 Move get_naive_bayes_best_move();
 Confusion_Matrix calculate_confusion_matrix();
+Confusion_Matrix count_confusion_matrix(void (*predict_batch)(const void *model_data, const ML_Data_Row data_rows[], int count, Predicted_Result predicted_results[]), const void *model_data, const ML_Data_Row test_rows[], int data_count);
+void add_to_confusion_matrix(Confusion_Matrix *confusion_matrix, Data_Result actual_result, Data_Result predicted_result);
+void normalize_confusion_matrix(Confusion_Matrix *confusion_matrix);
+unsigned int pack_board(const Tile tile[9]);
+void knn_train(Knn_Model *model, const ML_Data_Row data_rows[], int count);
+void knn_predict_batch(const Knn_Model *model, const unsigned int candidates[], int candidate_count, Predicted_Result predicted_results[]);
+Move get_knn_best_move();
+void mlp_init(Mlp_Model *model, unsigned long long seed);
+void mlp_hidden_layer(const Mlp_Model *model, const ML_Data_Row *data_row, float hidden[MLP_HIDDEN_SIZE]);
+void mlp_train_task(int task_index, void *context);
+void mlp_train(Mlp_Model *model, const ML_Data_Row data_rows[], int data_count, unsigned long long seed);
+void mlp_predict_batch(const void *model_data, const ML_Data_Row data_rows[], int count, Predicted_Result predicted_results[]);
+Move get_mlp_best_move();
+void mlp_quantize(const Mlp_Model *model, Quantized_Mlp_Model *quantized_model);
+void quantized_mlp_predict_batch(const void *model_data, const ML_Data_Row data_rows[], int count, Predicted_Result predicted_results[]);
+void run_mlp_calibration(unsigned int seed);
+void naive_bayes_score_rows(const Naive_Bayes_Model *model, const ML_Data_Row data_rows[], int count, float scores[]);
+unsigned int score_to_key(float score);
+float key_to_score(unsigned int key);
+void radix_sort(unsigned long long items[], unsigned long long buffer[], int count);
+Roc_Curve calculate_roc_curve(const float scores[], const Data_Result results[], int count);
+void free_roc_curve(Roc_Curve *curve);
+Roc_Curve calculate_naive_bayes_roc_curve();
+Roc_Curve calculate_mlp_roc_curve(const Mlp_Model *model, const Quantized_Mlp_Model *quantized_model, const ML_Data_Row test_rows[], int data_count);
+void render_roc_curve(const Roc_Curve *curve, Rectangle bounds);
+void run_roc_evaluation(unsigned int seed);
+int build_tree_node(Tree_Builder *builder, int indices[], int count, int depth, float parent_probability);
+void train_forest_tree(int tree, void *context);
+void train_random_forest(Random_Forest *forest, const ML_Data_Row data_rows[], int data_count, unsigned long long seed);
+void forest_predict_batch(const Random_Forest *forest, const ML_Data_Row data_rows[], int count, Predicted_Result predicted_results[]);
+Confusion_Matrix evaluate_random_forest(const Random_Forest *forest, const ML_Data_Row test_rows[], int data_count, Roc_Curve *roc_curve);
+Move get_forest_best_move();
+void cross_validation_fold(int fold, void *context);
+void run_cross_validation(int fold_count, unsigned int seed);
+void sweep_config_task(int task_index, void *context);
+void run_sweep(unsigned int seed);
+
+// function prototypes for dataset generation logic
+unsigned long long hash_bitboard(Bitboard board);
+void bitboard_set_init(Bitboard_Set *set, size_t expected_count);
+void bitboard_set_free(Bitboard_Set *set);
+bool bitboard_set_insert(Bitboard_Set *set, Bitboard board);
+void board_solver_init(Board_Solver *solver, int board_size, int table_bits);
+void board_solver_free(Board_Solver *solver);
+bool has_winning_line(const Board_Solver *solver, unsigned long long tiles);
+bool is_position_over(const Board_Solver *solver, Bitboard board);
+int solve_position(Board_Solver *solver, Bitboard board, int alpha, int beta);
+void add_labeled_position(Generator_Task *task, Board_Solver *solver, Bitboard board);
+void enumerate_positions(Generator_Task *task, Board_Solver *solver, Bitboard board);
+void generate_dataset_task(int task_index, void *context);
+void run_dataset_generator(int board_size, char file_name[], int sample_count, unsigned long long seed);
+
+// function prototypes for TD learning logic
+bool is_winning_mask(unsigned int tiles);
+void td_init_values(float values[]);
+void td_self_play_task(int task_index, void *context);
+void td_train(float values[], int game_count, unsigned long long seed);
+void td_quantize_values(const float values[], short quantized_values[]);
+void run_td_training(int game_count, char file_name[], unsigned long long seed);
+bool load_td_table(char file_name[]);
+Move get_td_best_move();
+void prepare_td_values();
+
+// function prototypes for spectator logic
+void load_spectator_atlas();
+void reset_spectator_game(Spectator_Game *game, unsigned long long now_ns);
+void start_spectating();
+void play_spectator_move(Spectator_Game *game);
+void step_spectator_games();
+void render_spectator_games();
+void update_spectator();
+
+// function prototypes for replay logic
+void start_replay();
+void record_replay_move(int row, int col);
+void save_replay();
+Bitboard replay_to_ply(const unsigned char moves[], int ply);
+Tile get_bitboard_winner(Bitboard board);
+size_t read_replay(const unsigned char *data, size_t size, size_t offset, Replay_Header *header, const unsigned char **moves);
+bool load_replay_archive(Replay_Archive *archive, char file_name[]);
+void free_replay_archive(Replay_Archive *archive);
+Replay_Header get_archived_replay(const Replay_Archive *archive, int index, const unsigned char **moves);
+void open_replay_viewer();
+void seek_replay(int index, int ply);
+void update_replay_viewer();
+size_t count_replay_stats(const unsigned char *data, size_t size, Replay_Stats *stats);
+void run_replay_stats(char file_name[]);
+
+// function prototypes for analysis logic
+void analysis_init(Analysis *analysis, int board_size, int table_bits);
+void analysis_free(Analysis *analysis);
+void analysis_set_position(Analysis *analysis, Bitboard board);
+int evaluate_analysis_board(const Board_Solver *solver, unsigned long long own, unsigned long long opponent);
+int analysis_search(Analysis *analysis, Bitboard board, int depth, int alpha, int beta);
+void analysis_step(Analysis *analysis, unsigned long long budget_ns);
+void render_analysis();
+void run_analysis_bench(int board_size, int frame_count);
+
+// function prototypes for random number logic
+unsigned long long splitmix64_next(unsigned long long *state);
+void random_seed(Random *random, unsigned long long seed);
+unsigned long long random_next(Random *random);
+unsigned long long random_below(Random *random, unsigned long long bound);
+float random_float(Random *random);
+void shuffle_elements(void *elements, size_t element_size, int count, Random *random);
+void shuffle_scatter_task(int chunk, void *context);
+void shuffle_block_task(int block, void *context);
+void parallel_shuffle(void *elements, size_t element_size, int count, Random *random);
+int *create_permutation(int count, Random *random);
+
+// function prototypes for threading and command line logic
+int get_thread_count();
+void run_parallel_tasks(Parallel_Job *job);
+void *parallel_worker(void *argument);
+void start_parallel_pool();
+void run_parallel(void (*task)(int task_index, void *context), int task_count, void *context);
+int run_command_line_tool(int argc, char *argv[]);
 
 // global constants for UI
 const int CELL_WIDTH = SCREEN_WIDTH / COLUMN;       // cell width is derived from width divided by no. of column
@@ -164,9 +945,31 @@ const float HALF_SCREEN_WIDTH = SCREEN_WIDTH / 2;   // half screen width is from
 const float HALF_SCREEN_HEIGHT = SCREEN_HEIGHT / 2; // half screen height is from dividing the screen height by 2
 const float WIN_LINE_THICKNESS = CELL_WIDTH / 4;    // the winning line thickness is a quarter of a cell size
 
+// global constants for ML
+const int CELL_WEIGHT[9] = {1, 3, 9, 27, 81, 243, 729, 2187, 6561}; // base 3 place value of each cell when encoding a board
+// cell that each cell is moved to by the 8 rotations and reflections of the board, the first is the identity
+const int D4_TRANSFORMS[8][9] = {
+    {0, 1, 2, 3, 4, 5, 6, 7, 8}, // identity
+    {2, 5, 8, 1, 4, 7, 0, 3, 6}, // rotate 90 degrees clockwise
+    {8, 7, 6, 5, 4, 3, 2, 1, 0}, // rotate 180 degrees
+    {6, 3, 0, 7, 4, 1, 8, 5, 2}, // rotate 270 degrees clockwise
+    {2, 1, 0, 5, 4, 3, 8, 7, 6}, // mirror left and right
+    {6, 7, 8, 3, 4, 5, 0, 1, 2}, // mirror top and bottom
+    {0, 3, 6, 1, 4, 7, 2, 5, 8}, // mirror along the main diagonal
+    {8, 5, 2, 7, 4, 1, 6, 3, 0}  // mirror along the anti diagonal
+};
+const unsigned int WINNING_MASKS[8] = {0x007, 0x038, 0x1C0, 0x049, 0x092, 0x124, 0x111, 0x054}; // cells of every row, column and diagonal, bit i is cell i
+const char *SWEEP_MODEL_NAMES[SWEEP_MODEL_COUNT] = {"naive_bayes", "nearest_neighbour", "neural_network", "random_forest"}; // name of each model in the csv of the sweep
+const int FPS_CAPS[4] = {30, 60, 120, 0};              // frame rate cap of each option in FPS_CAP_OPTIONS, 0 is unlimited
+const char *GAMEMODE_NAMES[REPLAY_GAMEMODE_COUNT] = {"Local", "Mini Max AI", "Machine Learning", "Nearest Neighbour", "TD Learning", "Neural Network", "Random Forest"}; // name of each gamemode in the replays
+const char *DIFFICULTY_NAMES[3] = {"Easy", "Medium", "Hard"}; // name of each difficulty of the minimax AI
+const char *RESOURCE_PACK_FILES[4] = {TEXTURE_FILE_PATH, GUI_FILE_PATH, NB_DATASET_FILE, TD_TABLE_FILE}; // every file that is packed by --pack-resources
+
 // global variables for game logic
 Texture2D g_cross_circle_texture;                      // texture2D containing the cross and circle texture
-clock_t g_start_time, g_elapsed_time;                  // clock variable for counting elapsed time
+RenderTexture2D g_board_layer;                         // the grid lines and tiles, only redrawn when the board changes
+bool g_board_layer_dirty = true;                       // whether the board has changed since g_board_layer was drawn
+unsigned long long g_game_end_ns;                      // monotonic time in nanoseconds when the game was won or drawn, for the countdown
 Tile g_grid[ROW][COLUMN];                              // tile2D array that holds the value of the whole tic tac toe grid
 Player g_player_one, g_player_two;                     // player struct variables for the two players
 Player *gp_current_player;                             // pointer variable to the player struct, either player one or two
@@ -175,13 +978,90 @@ Move g_winner_start, g_winner_end;                     // move struct variable t
 Gamemode g_current_gamemode;                           // gamemode struct variable that holds the current gamemode
 DifficultyMode g_game_difficulty_mode;                 // difficulty variable that holds the current difficulty for mini max AI
 State g_previous_state = NONE, g_current_state = MENU; // state variable that holds the current and previous game state
+unsigned int g_session_seed;                           // seed that the ML models are shuffled and trained with, the time the game was launched
+
+// global variables for startup logic
+unsigned long long g_process_start_ns;                 // monotonic time when main started, the startup phases are measured from it
+Startup_Phase g_startup_phases[STARTUP_MAX_PHASES];    // every startup phase in the order they finished
+int g_startup_phase_count = 0;                         // number of startup phases recorded, incremented atomically
+pthread_t g_startup_thread;                            // thread that runs the startup loader
+bool g_startup_thread_started = false;                 // whether the startup loader thread is running or has not been joined yet
+bool g_startup_loader_finished = false;                // set by the startup loader once it is done, read atomically
+bool g_startup_reported = false;                       // whether the startup report has been printed
+pthread_t g_model_training_threads[GAMEMODE_COUNT];    // thread that trains the model of a gamemode the first time the gamemode is started
+bool g_model_training_thread_started[GAMEMODE_COUNT];  // whether the training thread of a gamemode has been started and not joined yet
+
+// global variables for resource pack logic
+unsigned char *gp_resource_pack = NULL;                // the decompressed resource pack, NULL if the game was built without EMBED_RESOURCES
+
+// global variables for frame pacing logic
+int g_fps_cap_option = DEFAULT_FPS_CAP_OPTION;         // index of the frame rate cap chosen in the settings
+int g_applied_fps_cap = -1;                            // frame rate cap that is passed to raylib, -1 until the first frame
+int g_requested_frames = 0;                            // number of frames to draw before the game waits for input again
+bool g_waiting_for_events = false;                     // whether raylib waits for input at the end of every frame
 
 // global variables for ML logic
-ML_Data_Row g_dataset_array[MAX_DATASET_SIZE];         // array of ML_data_row struct that contains each line for the dataset
-int g_dataset_count = 0;                               // int to count how many lines of dataset
-double g_naive_bayes_probability[9][6];                // 2d array of a double for each tile and its possible tile and result (9 positions, 3 type of tiles and 2 results)
-double g_positive_counter = 0, g_negative_counter = 0; // counter for the number of positive and negative results, also used for prior probability
+ML_Data_Row *gp_dataset_array = NULL;                  // array of ML_data_row struct that contains each line for the dataset
+int g_dataset_count = 0, g_dataset_capacity = 0;       // int to count how many lines of dataset, and how many lines the array can hold
+bool g_dataset_shuffled = false;                       // whether the dataset has been shuffled, so that every model uses the same training and test data
+ML_Data_Row *gp_learned_games = NULL;                  // final boards of the games finished this session, kept apart so that the splits of gp_dataset_array never change
+int g_learned_game_count = 0, g_learned_game_capacity = 0; // number of finished games, and how many the array can hold
+int g_applied_game_count = 0;                          // number of finished games that have been added to the naive bayes model
+Naive_Bayes_Model g_naive_bayes_models[2];             // double buffered naive bayes models, one is used by the game while the other is updated
+Naive_Bayes_Model *gp_naive_bayes_model = &g_naive_bayes_models[0]; // pointer to the model used for prediction, swapped atomically after an update
+int g_naive_bayes_readers[2];                          // number of readers of each model, an update waits until the model it writes has no readers
+pthread_mutex_t g_naive_bayes_update_lock = PTHREAD_MUTEX_INITIALIZER; // mutex so that only one thread updates the models at a time
+bool g_naive_bayes_trained = false;                    // whether the model has been trained from the dataset, after that it only learns from finished games
 Confusion_Matrix g_current_confusion_matrix;           // a struct containing all the relevant values for a confusion matrix
+Roc_Curve g_current_roc_curve;                         // ROC curve of the naive bayes model on the test data
+Knn_Model g_knn_model;                                 // the nearest neighbour model that is used by the game
+bool g_knn_trained = false;                            // whether the nearest neighbour model has been built from the dataset, set atomically by its training thread
+Mlp_Model g_mlp_model;                                 // the neural network that is used by the game
+bool g_mlp_trained = false;                            // whether the neural network and its results are ready, set atomically by its training thread
+Confusion_Matrix g_mlp_confusion_matrix;               // confusion matrix of the neural network on the test data
+Quantized_Mlp_Model g_quantized_mlp_model;             // the neural network with int8 weights, quantized after training
+Confusion_Matrix g_quantized_mlp_confusion_matrix;     // confusion matrix of the quantized neural network on the test data
+Roc_Curve g_mlp_roc_curve, g_quantized_mlp_roc_curve;  // ROC curves of the neural network and the quantized neural network on the test data
+Random_Forest g_random_forest;                         // the random forest that is used by the game
+bool g_forest_trained = false;                         // whether the random forest and its results are ready, set atomically by its training thread
+Confusion_Matrix g_forest_confusion_matrix;            // confusion matrix of the random forest on the test data
+Roc_Curve g_forest_roc_curve;                          // ROC curve of the random forest on the test data
+bool g_mlp_quantized = false;                          // whether the game uses the quantized neural network, toggled in the settings
+const short *gp_td_values = NULL;                      // TD value of every board for cross, mapped from the TD table file or trained in memory
+short g_td_fallback_values[BOARD_STATE_COUNT];         // values trained in memory when the TD table file cannot be loaded
+
+// global variables for performance HUD logic
+Perf_Stats g_perf_stats;                               // frame statistics shown by the performance HUD
+bool g_perf_hud_visible = false;                       // whether the performance HUD is drawn, toggled with PERF_HUD_KEY
+rlRenderBatch g_perf_batch;                            // render batch of the game, owned by the game so that its draw calls can be counted
+
+// global variables for tracing logic
+Trace_Buffer *gp_trace_buffers[TRACE_MAX_BUFFERS];     // pool of trace buffers, allocated when a thread first needs one and reused after it exits
+int g_trace_thread_count = 0;                          // number of threads that have recorded events, used to give each thread a trace id
+pthread_key_t g_trace_buffer_key;                      // key whose destructor releases the trace buffer of an exiting thread
+pthread_once_t g_trace_buffer_key_once = PTHREAD_ONCE_INIT; // makes sure g_trace_buffer_key is only created once
+__thread Trace_Buffer *gp_thread_trace_buffer = NULL;  // trace buffer of the calling thread
+__thread int g_thread_trace_id = 0;                    // trace id of the calling thread
+
+// global variables for spectator logic
+Spectator_Game g_spectator_games[SPECTATOR_GAME_COUNT]; // every game of the spectator view
+Random g_spectator_random;                             // random generator of the spectator games
+Texture2D g_spectator_atlas;                           // texture atlas that every board of the spectator view is drawn with, loaded when the view is first opened
+int g_spectator_results[3];                            // number of finished spectator games indexed by the winning tile, EMPTY for draws
+
+// global variables for replay logic
+Replay g_replay;                                       // replay of the current game
+FILE *gp_replay_file = NULL;                           // REPLAY_FILE, opened when the first game is finished and kept open
+Replay_Archive g_replay_archive;                       // the replays shown by the replay viewer, read when the viewer is opened
+int g_replay_index = 0, g_replay_ply = 0;              // the replay and the number of its moves shown by the viewer
+Bitboard g_replay_board;                               // the board of the replay after g_replay_ply moves
+
+// global variables for threading logic
+Parallel_Pool g_parallel_pool = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER, PTHREAD_MUTEX_INITIALIZER, {0}, 0, NULL, 0, 0};
+
+// global variables for analysis logic
+Analysis g_analysis;                                   // analysis of the board of the current game, its table is allocated and cleared with the game assets
+bool g_analysis_visible = false;                       // whether the analysis heatmap is drawn, toggled with ANALYSIS_KEY
 
 // current grid design, row = 3, column = 3
 // 0,0 | 0,1 | 0,2
@@ -194,19 +1074,46 @@ Main function of the program
 Initiate certain variables and functions that are to be ran one time only
 Contains the main loop of the game
 */
-int main(void)
+int main(int argc, char *argv[])
 {
+    // run a headless tool instead of the game if it is requested from the command line
+    if (argc > 1)
+        return run_command_line_tool(argc, argv);
+
+    g_process_start_ns = get_monotonic_ns();
+    g_session_seed = time(NULL);
+    // take the first trace buffer, so that the main thread is the first thread of the trace
+    acquire_trace_buffer();
+    // decompress the embedded resources before anything is loaded, so that no file is read at launch
+    STARTUP_CALL("load_resource_pack", false, load_resource_pack());
+    // load the dataset and train in the background, so that the menu is shown without waiting for it
+    start_startup_loader();
     // initialize the window and size using raylib's library
-    InitWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Tic Tac Toe");
-    // load the texture for the cross and circle
-    g_cross_circle_texture = LoadTexture(TEXTURE_FILE_PATH);
+    STARTUP_CALL("InitWindow", false, InitWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Tic Tac Toe"));
+    // draw with a render batch of the same size as raylib's, but owned by the game so that the HUD can count its draw calls
+    g_perf_batch = rlLoadRenderBatch(RL_DEFAULT_BATCH_BUFFERS, RL_DEFAULT_BATCH_BUFFER_ELEMENTS);
+    rlSetRenderBatchActive(&g_perf_batch);
     SetExitKey(0); // prevent esc from closing the window
-    read_ml_dataset(NB_DATASET_FILE);
-    GuiLoadStyle(GUI_FILE_PATH);
+    // the menu uses the style, the textures of the game are loaded when the first game starts
+    STARTUP_CALL("load_gui_style", false, load_gui_style());
 
     // main game loop
     while (!WindowShouldClose())
     {
+        // cap the frame rate, and wait for input at the end of the frame if nothing on screen is changing by itself
+        update_frame_pacing();
+
+        // write the trace of the last frames without closing the game
+        if (IsKeyPressed(TRACE_KEY))
+            write_trace_file(TRACE_FILE);
+        // show or hide the performance HUD, and add the last frame to its statistics
+        if (IsKeyPressed(PERF_HUD_KEY))
+            g_perf_hud_visible = !g_perf_hud_visible;
+        // show or hide the value of every empty cell during a game
+        if (IsKeyPressed(ANALYSIS_KEY))
+            g_analysis_visible = !g_analysis_visible;
+        record_frame_stats();
+
         // if state changes, means this state is just entered, run init function
         if (g_previous_state != g_current_state)
         {
@@ -217,26 +1124,68 @@ int main(void)
         switch (g_current_state)
         {
         case MENU:
-            update_menu();
+            TRACE_CALL("update_menu", update_menu());
             break;
         case GAME:
-            update_game();
-            update_game_render();
+        {
+            unsigned long long update_start_ns = get_monotonic_ns();
+            TRACE_CALL("update_game", update_game());
+            g_perf_stats.update_ns += get_monotonic_ns() - update_start_ns;
+            TRACE_CALL("update_game_render", update_game_render());
             break;
+        }
         case SETTING:
-            update_setting();
+            TRACE_CALL("update_setting", update_setting());
             break;
         case GAMEOVER:
-            update_gameover();
+            TRACE_CALL("update_gameover", update_gameover());
             break;
         case PAUSE:
-            update_pause();
+            TRACE_CALL("update_pause", update_pause());
+            break;
+        case SPECTATE:
+            TRACE_CALL("update_spectator", update_spectator());
+            break;
+        case REPLAY:
+            TRACE_CALL("update_replay_viewer", update_replay_viewer());
             break;
         default:
             exit(1);
         }
+
+        // the first frame has been drawn, print the startup report once the startup loader has also finished
+        if (!g_startup_reported)
+        {
+            static bool first_frame_recorded = false;
+            if (!first_frame_recorded)
+            {
+                record_startup_phase("first frame", g_process_start_ns, false);
+                first_frame_recorded = true;
+            }
+            if (is_startup_loader_finished())
+            {
+                print_startup_report();
+                g_startup_reported = true;
+            }
+        }
     }
 
+    wait_for_startup_loader();
+    join_model_training_threads();
+    write_trace_file(TRACE_FILE);
+    rlSetRenderBatchActive(NULL);
+    rlUnloadRenderBatch(g_perf_batch);
+    if (g_cross_circle_texture.id != 0)
+    {
+        UnloadRenderTexture(g_board_layer);
+        UnloadTexture(g_cross_circle_texture);
+    }
+    if (g_spectator_atlas.id != 0)
+        UnloadTexture(g_spectator_atlas);
+    if (gp_replay_file != NULL)
+        fclose(gp_replay_file);
+    free_replay_archive(&g_replay_archive);
+    analysis_free(&g_analysis);
     CloseWindow();
     return 0;
 }
@@ -253,6 +1202,7 @@ void init()
         break;
     case GAME:
         SetWindowSize(SCREEN_WIDTH, SCREEN_HEIGHT + UI_OFFSET);
+        load_game_assets();
         if (g_previous_state != PAUSE)
             start_game();
         break;
@@ -265,6 +1215,15 @@ void init()
     case PAUSE:
         SetWindowSize(SCREEN_WIDTH, SCREEN_HEIGHT);
         break;
+    case SPECTATE:
+        SetWindowSize(SCREEN_WIDTH, SCREEN_HEIGHT + UI_OFFSET);
+        start_spectating();
+        break;
+    case REPLAY:
+        SetWindowSize(SCREEN_WIDTH, SCREEN_HEIGHT + UI_OFFSET);
+        load_game_assets();
+        open_replay_viewer();
+        break;
     default:
         exit(1);
     }
@@ -275,6 +1234,13 @@ start a fresh game of tic tac toe function
 */
 void start_game()
 {
+    // the AI modes use the dataset and the TD values, which may still be loading in the background
+    if (g_current_gamemode != LOCAL && g_current_gamemode != AI_MINIMAX)
+        wait_for_startup_loader();
+    // games that finished before the model was trained are learned once the loader is done
+    apply_learned_games();
+    // the other ML models are trained in the background the first time their gamemode is started, the AI waits for its turn until then
+    start_model_training(g_current_gamemode);
     // set all the grids to be empty
     populate_grid(EMPTY);
     // if the currenmt gamemode is local, set player one and two to be human
@@ -292,9 +1258,19 @@ void start_game()
     // else if the current gamemode is machine learning, init relevant functions and set player one to be human and player two to be AI
     else if (g_current_gamemode == AI_ML)
     {
-        shuffle_dataset();
-        naive_bayes_learn(TRAINING_DATA_WEIGHT);
-        g_current_confusion_matrix = calculate_confusion_matrix();
+        // the model is trained from the dataset once by the startup loader, after that it keeps learning from every finished game
+        g_player_one = (Player){PLAYER_HUMAN, CROSS};
+        g_player_two = (Player){PLAYER_AI, CIRCLE};
+    }
+    // else if the current gamemode is nearest neighbour, neural network or random forest, set player one to be human and player two to be AI
+    else if (g_current_gamemode == AI_KNN || g_current_gamemode == AI_MLP || g_current_gamemode == AI_FOREST)
+    {
+        g_player_one = (Player){PLAYER_HUMAN, CROSS};
+        g_player_two = (Player){PLAYER_AI, CIRCLE};
+    }
+    // else if the current gamemode is TD learning, set player one to be human and player two to be AI, the values were loaded or trained by the startup loader
+    else if (g_current_gamemode == AI_TD)
+    {
         g_player_one = (Player){PLAYER_HUMAN, CROSS};
         g_player_two = (Player){PLAYER_AI, CIRCLE};
     }
@@ -302,6 +1278,7 @@ void start_game()
     // set the starting player to be player one and clear the winner
     gp_current_player = &g_player_one;
     gp_winner = NULL;
+    start_replay();
 }
 
 /*
@@ -309,6 +1286,9 @@ Render loop for all render related functions for the game
 */
 void update_game_render()
 {
+    unsigned long long render_start_ns = get_monotonic_ns();
+    // redraw the cached board if it has changed, this has to be done outside of the drawing buffer
+    update_board_layer();
     // start drawing buffer
     BeginDrawing();
     // clear screen and set white
@@ -317,8 +1297,14 @@ void update_game_render()
     render_grid();
     // render the text ui during the game
     render_text_ui();
+    // render the performance HUD over the board if it is turned on
+    if (g_perf_hud_visible)
+        render_perf_hud();
+    // count the draw calls before EndDrawing() sends the batch to the GPU and clears it
+    g_perf_stats.draw_calls = count_draw_calls();
+    g_perf_stats.render_ns += get_monotonic_ns() - render_start_ns;
     // end drawing buffer
-    EndDrawing();
+    TRACE_CALL("EndDrawing", EndDrawing());
 }
 
 /*
@@ -349,8 +1335,14 @@ void update_menu()
     if (GuiButton((Rectangle){HALF_SCREEN_WIDTH - BUTTON_WIDTH / 2, HALF_SCREEN_HEIGHT - BUTTON_HEIGHT / 2 + BUTTON_HEIGHT * 2.4, BUTTON_WIDTH, BUTTON_HEIGHT}, "Quit"))
         CloseWindow();
 
+    // draw the spectate button under the other buttons
+    if (GuiButton((Rectangle){HALF_SCREEN_WIDTH - BUTTON_WIDTH / 2, HALF_SCREEN_HEIGHT - BUTTON_HEIGHT / 2 + BUTTON_HEIGHT * 3.6, BUTTON_WIDTH, BUTTON_HEIGHT / 2}, "Spectate AI Games"))
+    {
+        set_current_state(SPECTATE);
+    }
+
     // end drawing buffer
-    EndDrawing();
+    TRACE_CALL("EndDrawing", EndDrawing());
 }
 
 /*
@@ -387,7 +1379,7 @@ void update_game()
         else if (gp_current_player == &g_player_two)
         {
             // get the best move from minimax algo and then set the tile and change player turn
-            Move best_move = get_mini_max_best_move();
+            Move best_move = get_timed_ai_move("get_mini_max_best_move", get_mini_max_best_move);
             set_tile(best_move.row, best_move.column, g_player_two.tile);
             change_player_turn();
         }
@@ -401,7 +1393,63 @@ void update_game()
         else if (gp_current_player == &g_player_two)
         {
             // get the best move from naive bayes algo and then set tile and change player turn
-            Move best_move = get_naive_bayes_best_move();
+            Move best_move = get_timed_ai_move("get_naive_bayes_best_move", get_naive_bayes_best_move);
+            set_tile(best_move.row, best_move.column, g_player_two.tile);
+            change_player_turn();
+        }
+        break;
+    case AI_KNN:
+        // receive user input and place tile
+        if (gp_current_player == &g_player_one)
+        {
+            handle_mouse_input();
+        }
+        else if (gp_current_player == &g_player_two && is_model_trained(AI_KNN))
+        {
+            // get the best move from the nearest neighbours once it has been trained and then set tile and change player turn
+            Move best_move = get_timed_ai_move("get_knn_best_move", get_knn_best_move);
+            set_tile(best_move.row, best_move.column, g_player_two.tile);
+            change_player_turn();
+        }
+        break;
+    case AI_TD:
+        // receive user input and place tile
+        if (gp_current_player == &g_player_one)
+        {
+            handle_mouse_input();
+        }
+        else if (gp_current_player == &g_player_two)
+        {
+            // get the best move from the TD values and then set tile and change player turn
+            Move best_move = get_timed_ai_move("get_td_best_move", get_td_best_move);
+            set_tile(best_move.row, best_move.column, g_player_two.tile);
+            change_player_turn();
+        }
+        break;
+    case AI_MLP:
+        // receive user input and place tile
+        if (gp_current_player == &g_player_one)
+        {
+            handle_mouse_input();
+        }
+        else if (gp_current_player == &g_player_two && is_model_trained(AI_MLP))
+        {
+            // get the best move from the neural network once it has been trained and then set tile and change player turn
+            Move best_move = get_timed_ai_move("get_mlp_best_move", get_mlp_best_move);
+            set_tile(best_move.row, best_move.column, g_player_two.tile);
+            change_player_turn();
+        }
+        break;
+    case AI_FOREST:
+        // receive user input and place tile
+        if (gp_current_player == &g_player_one)
+        {
+            handle_mouse_input();
+        }
+        else if (gp_current_player == &g_player_two && is_model_trained(AI_FOREST))
+        {
+            // get the best move from the random forest once it has been trained and then set tile and change player turn
+            Move best_move = get_timed_ai_move("get_forest_best_move", get_forest_best_move);
             set_tile(best_move.row, best_move.column, g_player_two.tile);
             change_player_turn();
         }
@@ -431,28 +1479,62 @@ void update_setting()
     // draw the text of the settings
     DrawText(TITLE, HALF_SCREEN_WIDTH - MeasureText(TITLE, 60) / 2, HALF_SCREEN_HEIGHT / 2, TITLE_FONT_SIZE, TITLE_COLOUR);
     // drawing the gui box for the different gamemodes
-    GuiComboBox((Rectangle){HALF_SCREEN_WIDTH - BUTTON_WIDTH / 2, HALF_SCREEN_HEIGHT - BUTTON_HEIGHT / 2, BUTTON_WIDTH, BUTTON_HEIGHT}, "Local;Mini Max AI;Machine Learning", (int *)&g_current_gamemode);
+    GuiComboBox((Rectangle){HALF_SCREEN_WIDTH - BUTTON_WIDTH / 2, HALF_SCREEN_HEIGHT - BUTTON_HEIGHT / 2, BUTTON_WIDTH, BUTTON_HEIGHT}, "Local;Mini Max AI;Machine Learning;Nearest Neighbour;TD Learning;Neural Network;Random Forest", (int *)&g_current_gamemode);
 
     // if current gamemode is minimax, show difficulty setting, else if current gamemode is ML, show confusion matrix as button 2
     if (g_current_gamemode == AI_MINIMAX)
     {
         GuiComboBox((Rectangle){HALF_SCREEN_WIDTH - BUTTON_WIDTH / 2, HALF_SCREEN_HEIGHT - BUTTON_HEIGHT / 2 + BUTTON_HEIGHT * 1.2, BUTTON_WIDTH, BUTTON_HEIGHT}, "Easy;Medium;Hard", (int *)&g_game_difficulty_mode);
     }
-    // if the gamemode is ML, we show the confusion matrix
-    else if (g_current_gamemode == AI_ML)
+    // if the gamemode is ML, neural network or random forest, we show the confusion matrix of its model
+    else if (g_current_gamemode == AI_ML || g_current_gamemode == AI_MLP || g_current_gamemode == AI_FOREST)
     {
+        // the models are trained in the background, so their results are empty until their training has finished
+        static const Roc_Curve empty_roc_curve = {NULL, NULL, 0, 0, 0, 0};
+        Confusion_Matrix confusion_matrix = {0, 0, 0, 0, 0, 0};
+        const Roc_Curve *roc_curve = &empty_roc_curve;
+
+        if (g_current_gamemode == AI_ML && is_startup_loader_finished())
+        {
+            confusion_matrix = g_current_confusion_matrix;
+            roc_curve = &g_current_roc_curve;
+        }
+        else if (g_current_gamemode == AI_MLP && is_model_trained(AI_MLP))
+        {
+            confusion_matrix = g_mlp_quantized ? g_quantized_mlp_confusion_matrix : g_mlp_confusion_matrix;
+            roc_curve = g_mlp_quantized ? &g_quantized_mlp_roc_curve : &g_mlp_roc_curve;
+        }
+        else if (g_current_gamemode == AI_FOREST && is_model_trained(AI_FOREST))
+        {
+            confusion_matrix = g_forest_confusion_matrix;
+            roc_curve = &g_forest_roc_curve;
+        }
+
         // Draw confusion matrix as a table, TP(True Positive), FP(False Positive), TN(True Negative), FN(False Negative)
         GuiGroupBox((Rectangle){HALF_SCREEN_WIDTH - BUTTON_WIDTH / 2, HALF_SCREEN_HEIGHT - BUTTON_HEIGHT / 2 + BUTTON_HEIGHT * 1.2, BUTTON_WIDTH, BUTTON_HEIGHT}, "Confusion Matrix");
-        DrawText(TextFormat("TP: %g", g_current_confusion_matrix.true_positive), HALF_SCREEN_WIDTH - BUTTON_WIDTH / 2 + 10, HALF_SCREEN_HEIGHT - BUTTON_HEIGHT / 2 + BUTTON_HEIGHT * 1.2 + 10, 20, TITLE_COLOUR);
-        DrawText(TextFormat("FP: %g", g_current_confusion_matrix.false_positive), HALF_SCREEN_WIDTH - BUTTON_WIDTH / 2 + 10, HALF_SCREEN_HEIGHT - BUTTON_HEIGHT / 2 + BUTTON_HEIGHT * 1.2 + 30, 20, TITLE_COLOUR);
-        DrawText(TextFormat("TN: %g", g_current_confusion_matrix.true_negative), HALF_SCREEN_WIDTH - BUTTON_WIDTH / 2 + 10, HALF_SCREEN_HEIGHT - BUTTON_HEIGHT / 2 + BUTTON_HEIGHT * 1.2 + 50, 20, TITLE_COLOUR);
-        DrawText(TextFormat("FN: %g", g_current_confusion_matrix.false_negative), HALF_SCREEN_WIDTH - BUTTON_WIDTH / 2 + 10, HALF_SCREEN_HEIGHT - BUTTON_HEIGHT / 2 + BUTTON_HEIGHT * 1.2 + 70, 20, TITLE_COLOUR);
+        DrawText(TextFormat("TP: %g", confusion_matrix.true_positive), HALF_SCREEN_WIDTH - BUTTON_WIDTH / 2 + 10, HALF_SCREEN_HEIGHT - BUTTON_HEIGHT / 2 + BUTTON_HEIGHT * 1.2 + 10, 20, TITLE_COLOUR);
+        DrawText(TextFormat("FP: %g", confusion_matrix.false_positive), HALF_SCREEN_WIDTH - BUTTON_WIDTH / 2 + 10, HALF_SCREEN_HEIGHT - BUTTON_HEIGHT / 2 + BUTTON_HEIGHT * 1.2 + 30, 20, TITLE_COLOUR);
+        DrawText(TextFormat("TN: %g", confusion_matrix.true_negative), HALF_SCREEN_WIDTH - BUTTON_WIDTH / 2 + 10, HALF_SCREEN_HEIGHT - BUTTON_HEIGHT / 2 + BUTTON_HEIGHT * 1.2 + 50, 20, TITLE_COLOUR);
+        DrawText(TextFormat("FN: %g", confusion_matrix.false_negative), HALF_SCREEN_WIDTH - BUTTON_WIDTH / 2 + 10, HALF_SCREEN_HEIGHT - BUTTON_HEIGHT / 2 + BUTTON_HEIGHT * 1.2 + 70, 20, TITLE_COLOUR);
+
+        // draw the ROC curve next to the matrix, with the AUC and the best threshold, which are empty until the model is trained
+        render_roc_curve(roc_curve, (Rectangle){HALF_SCREEN_WIDTH - BUTTON_WIDTH / 2 + 125, HALF_SCREEN_HEIGHT - BUTTON_HEIGHT / 2 + BUTTON_HEIGHT * 1.2 + 15, 75, 75});
+        DrawText(TextFormat("AUC %.2f", roc_curve->auc), HALF_SCREEN_WIDTH - BUTTON_WIDTH / 2 + 210, HALF_SCREEN_HEIGHT - BUTTON_HEIGHT / 2 + BUTTON_HEIGHT * 1.2 + 15, 16, TITLE_COLOUR);
+        DrawText(TextFormat("T %.2f", roc_curve->best_threshold), HALF_SCREEN_WIDTH - BUTTON_WIDTH / 2 + 210, HALF_SCREEN_HEIGHT - BUTTON_HEIGHT / 2 + BUTTON_HEIGHT * 1.2 + 35, 16, TITLE_COLOUR);
+        DrawText(TextFormat("Acc %.2f", roc_curve->best_accuracy), HALF_SCREEN_WIDTH - BUTTON_WIDTH / 2 + 210, HALF_SCREEN_HEIGHT - BUTTON_HEIGHT / 2 + BUTTON_HEIGHT * 1.2 + 55, 16, TITLE_COLOUR);
+
+        // the neural network can switch to int8 weights, the confusion matrix and ROC curve then show the quantized network
+        if (g_current_gamemode == AI_MLP)
+            GuiCheckBox((Rectangle){HALF_SCREEN_WIDTH - BUTTON_WIDTH / 2 + 210, HALF_SCREEN_HEIGHT - BUTTON_HEIGHT / 2 + BUTTON_HEIGHT * 1.2 + 75, 15, 15}, "Int8", &g_mlp_quantized);
     }
 
     // print the return to main menu button
     if (GuiButton((Rectangle){HALF_SCREEN_WIDTH - BUTTON_WIDTH / 2, HALF_SCREEN_HEIGHT - BUTTON_HEIGHT / 2 + BUTTON_HEIGHT * 2.4, BUTTON_WIDTH, BUTTON_HEIGHT}, "Return to Main Menu"))
         set_current_state(MENU);
-    EndDrawing();
+
+    // draw the frame rate cap under the buttons, it is applied at the start of the next frame
+    GuiComboBox((Rectangle){HALF_SCREEN_WIDTH - BUTTON_WIDTH / 2, HALF_SCREEN_HEIGHT - BUTTON_HEIGHT / 2 + BUTTON_HEIGHT * 3.6, BUTTON_WIDTH, BUTTON_HEIGHT / 2}, FPS_CAP_OPTIONS, &g_fps_cap_option);
+    TRACE_CALL("EndDrawing", EndDrawing());
 }
 
 /*
@@ -478,7 +1560,7 @@ void update_pause()
         set_current_state(MENU);
 
     // clear drawing buffer
-    EndDrawing();
+    TRACE_CALL("EndDrawing", EndDrawing());
 }
 
 /*
@@ -518,8 +1600,11 @@ void update_gameover()
     // draw the return to main menu button
     if (GuiButton((Rectangle){HALF_SCREEN_WIDTH - BUTTON_WIDTH / 2, HALF_SCREEN_HEIGHT - BUTTON_HEIGHT / 2 + BUTTON_HEIGHT * 1.2, BUTTON_WIDTH, BUTTON_HEIGHT}, "Return to Main Menu"))
         set_current_state(MENU);
+    // draw the button that opens the replay viewer at the game that has just finished
+    if (GuiButton((Rectangle){HALF_SCREEN_WIDTH - BUTTON_WIDTH / 2, HALF_SCREEN_HEIGHT - BUTTON_HEIGHT / 2 + BUTTON_HEIGHT * 2.4, BUTTON_WIDTH, BUTTON_HEIGHT / 2}, "Watch Replay"))
+        set_current_state(REPLAY);
 
-    EndDrawing();
+    TRACE_CALL("EndDrawing", EndDrawing());
 }
 
 /*
@@ -532,6 +1617,9 @@ void set_current_state(State state)
 
     g_previous_state = g_current_state;
     g_current_state = state;
+
+    // the state changes while the old screen is drawn, so the new screen needs frames even if there is no input
+    request_frames(STATE_CHANGE_FRAMES);
 }
 
 /*
@@ -575,755 +1663,5725 @@ void change_player_turn()
         gp_current_player = &g_player_one;
 }
 
-// main grid rendering function
-void render_grid()
-{
-    // nested loop to go through every cell in the grid
-    for (int i = 0; i < ROW; i++)
-        for (int j = 0; j < COLUMN; j++)
-        {
-            // calculate the coordinates for each tile
-            int x_coord = j * CELL_WIDTH;
-            int y_coord = i * CELL_HEIGHT + UI_OFFSET;
-            // draw rectangles for each cell
-            DrawRectangleLines(x_coord, y_coord, CELL_WIDTH, CELL_HEIGHT, TITLE_COLOUR);
-            // we render each tile
-            render_tile(x_coord, y_coord, g_grid[i][j]);
-        }
-
-    // if the game is over, we draw the line and also show a countdown
-    if (gp_winner != NULL || is_board_full())
-    {
-        // if board is full and no winner, dont draw line, however if board is full but winner is found, draw line, else draw line if winner is found
-        if (!is_board_full() || gp_winner != NULL)
-            render_line(g_winner_start, g_winner_end, WIN_LINE_THICKNESS);
-        // get the current elapsed time
-        g_elapsed_time = (double)(clock() - g_start_time) / CLOCKS_PER_SEC;
-        // if elapsed time has crossed more than the delay, we change the state to gameover
-        if (g_elapsed_time >= GAME_END_DELAY + g_start_time)
-            set_current_state(GAMEOVER);
-        // draw the countdown timer
-        const char *countdown_timer = TextFormat("Game will end in %.1f", (float)((GAME_END_DELAY + g_start_time) - g_elapsed_time));
-        DrawText(countdown_timer, SCREEN_WIDTH / 2 - MeasureText(countdown_timer, 50) / 2, SCREEN_HEIGHT / 2 + UI_OFFSET, TITLE_FONT_SIZE, TITLE_COLOUR);
-    }
-}
-
 /*
-Function to render tile individual tiles
+Records a startup phase from start_ns until now for the startup report and the trace, name must be a string literal
+Can be called from the main thread and the startup loader at the same time
 */
-void render_tile(int x_coord, int y_coord, Tile tile)
+void record_startup_phase(const char *name, unsigned long long start_ns, bool background)
 {
-    // create a rectangle variable for where we want our tile to be
-    Rectangle destination = {x_coord, y_coord, CELL_WIDTH, CELL_HEIGHT};
-    Rectangle source;
+    trace_record(name, start_ns);
 
-    // switch case to render the tile according to the tile type
-    switch (tile)
-    {
-    case CROSS:
-        source = (Rectangle){0, 0, 100, 100};
-        DrawTexturePro(g_cross_circle_texture, source, destination, (Vector2){0, 0}, 0, WHITE);
-        break;
-    case CIRCLE:
-        source = (Rectangle){100, 0, 100, 100};
-        DrawTexturePro(g_cross_circle_texture, source, destination, (Vector2){0, 0}, 0, WHITE);
-        break;
-    case EMPTY:
-        break;
-    }
+    int index = __atomic_fetch_add(&g_startup_phase_count, 1, __ATOMIC_RELAXED);
+    if (index < STARTUP_MAX_PHASES)
+        g_startup_phases[index] = (Startup_Phase){name, start_ns - g_process_start_ns, get_monotonic_ns() - start_ns, background};
 }
 
 /*
-function to render the text ui at the top of game screen
+Loads the dataset and the TD table and trains the naive bayes model, ran on a background thread while the menu is shown
+The TD values are trained last if the TD table cannot be loaded, so that the game never trains them on the main thread
+Nothing here uses the window, as raylib can only draw and load textures on the main thread
 */
-void render_text_ui()
+void *run_startup_loader(void *argument)
 {
-    // get the coord at half of the screen
-    int x_coord = SCREEN_WIDTH / 2;
-    // get the coord at 1/6 of the blank area
-    int y_coord = UI_OFFSET / 6;
-    int font_size = 40;
-    char top_text[30] = "-";
-
-    // if the game is over, print respective title
-    if (gp_winner != NULL || is_board_full())
-    {
-        if (gp_winner == &g_player_one)
-            strcpy(top_text, "Player 1 wins!");
-        else if (gp_winner == &g_player_two)
-            strcpy(top_text, "Player 2 wins!");
-        else if (is_board_full())
-            strcpy(top_text, "Draw!");
-    }
-    else // if game is still going on print the current player turn
-    {
-        if (gp_current_player == &g_player_one)
-            strcpy(top_text, "Player 1's turn");
-        else if (gp_current_player)
-            strcpy(top_text, "Player 2's turn");
-    }
-
-    // draw the text
-    DrawText(top_text, x_coord - MeasureText(top_text, font_size) / 2, y_coord, font_size, TITLE_COLOUR);
+    (void)argument;
+
+    STARTUP_CALL("read_ml_dataset", true, read_ml_dataset(NB_DATASET_FILE));
+    STARTUP_CALL("load_td_table", true, load_td_table(TD_TABLE_FILE));
+    STARTUP_CALL("prepare_ml_dataset", true, prepare_ml_dataset());
+    STARTUP_CALL("naive_bayes_learn", true, naive_bayes_learn(TRAINING_DATA_WEIGHT));
+    STARTUP_CALL("evaluate_naive_bayes", true,
+                 g_current_confusion_matrix = calculate_confusion_matrix();
+                 g_current_roc_curve = calculate_naive_bayes_roc_curve());
+    g_naive_bayes_trained = true;
+    STARTUP_CALL("prepare_td_values", true, prepare_td_values());
+
+    // the main thread only reads the results after it sees this flag or joins the thread
+    __atomic_store_n(&g_startup_loader_finished, true, __ATOMIC_RELEASE);
+    return NULL;
 }
 
 /*
-Function to render the game over line using a start and end position and a thickness
+Starts the startup loader on a background thread, or runs it on the calling thread if a thread cannot be created
 */
-void render_line(Move start, Move end, float thickness)
+void start_startup_loader()
 {
-    Vector2 start_position = {start.column * CELL_WIDTH + CELL_WIDTH / 2, start.row * CELL_HEIGHT + CELL_HEIGHT / 2 + UI_OFFSET};
-    Vector2 end_position = {end.column * CELL_WIDTH + CELL_WIDTH / 2, end.row * CELL_HEIGHT + CELL_HEIGHT / 2 + UI_OFFSET};
-    static const Color red_translucent = (Color){255, 0, 0, 150};
-    DrawLineEx(start_position, end_position, thickness, red_translucent);
+    if (pthread_create(&g_startup_thread, NULL, run_startup_loader, NULL) == 0)
+        g_startup_thread_started = true;
+    else
+        run_startup_loader(NULL);
 }
 
 /*
-populate the grid according to tile input
+Returns whether the startup loader has finished, the results of the loader can be used once this returns true
 */
-void populate_grid(Tile tile)
+bool is_startup_loader_finished()
 {
-    for (int i = 0; i < ROW; i++)
-        for (int j = 0; j < COLUMN; j++)
-            g_grid[i][j] = tile;
+    if (!__atomic_load_n(&g_startup_loader_finished, __ATOMIC_ACQUIRE))
+        return false;
+
+    wait_for_startup_loader();
+    return true;
 }
 
 /*
-Sets the desired tile at the desired row and column
-Use this function to set the tile instead of directly accessing the g_grid array
+Waits until the startup loader has finished, called before anything that uses the dataset, the TD values or the naive bayes model
+Returns straight away once the loader has been joined
 */
-bool set_tile(int row, int col, Tile tile)
+void wait_for_startup_loader()
 {
-    if (is_tile_placeable(row, col))
+    if (g_startup_thread_started)
     {
-        g_grid[row][col] = tile;
-        if (check_win_condition())
-            g_start_time = (double)clock() / CLOCKS_PER_SEC;
-        return true;
+        unsigned long long start_ns = get_monotonic_ns();
+        pthread_join(g_startup_thread, NULL);
+        g_startup_thread_started = false;
+        trace_record("wait_for_startup_loader", start_ns);
     }
-    else
-        return false;
 }
 
 /*
-Checks if the desired tile is placeable
+Builds the nearest neighbour model on its training thread, started the first time its gamemode is started
 */
-bool is_tile_placeable(int row, int col)
+void *train_knn_model(void *argument)
 {
-    if (g_grid[row][col] == EMPTY)
-        return true;
-    else
-        return false;
+    (void)argument;
+    unsigned long long start_ns = get_monotonic_ns();
+
+    knn_train(&g_knn_model, gp_dataset_array, ceil(g_dataset_count * TRAINING_DATA_WEIGHT));
+    trace_record("train_knn_model", start_ns);
+
+    // the main thread only uses the model after it sees this flag
+    __atomic_store_n(&g_knn_trained, true, __ATOMIC_RELEASE);
+    return NULL;
 }
 
 /*
-Returns 1 if the board is full, else return 0
+Trains and quantizes the neural network and calculates the results shown in the settings, on its training thread
 */
-int is_board_full()
+void *train_mlp_model(void *argument)
 {
-    for (int i = 0; i < ROW; i++)
-    {
+    (void)argument;
+    unsigned long long start_ns = get_monotonic_ns();
+    int training_count = ceil(g_dataset_count * TRAINING_DATA_WEIGHT);
+
+    mlp_train(&g_mlp_model, gp_dataset_array, training_count, g_session_seed);
+    g_mlp_confusion_matrix = count_confusion_matrix(mlp_predict_batch, &g_mlp_model, &gp_dataset_array[training_count], g_dataset_count - training_count);
+    normalize_confusion_matrix(&g_mlp_confusion_matrix);
+
+    // quantize the trained network so that the settings can switch between the two
+    mlp_quantize(&g_mlp_model, &g_quantized_mlp_model);
+    g_quantized_mlp_confusion_matrix = count_confusion_matrix(quantized_mlp_predict_batch, &g_quantized_mlp_model, &gp_dataset_array[training_count], g_dataset_count - training_count);
+    normalize_confusion_matrix(&g_quantized_mlp_confusion_matrix);
+    g_mlp_roc_curve = calculate_mlp_roc_curve(&g_mlp_model, NULL, &gp_dataset_array[training_count], g_dataset_count - training_count);
+    g_quantized_mlp_roc_curve = calculate_mlp_roc_curve(NULL, &g_quantized_mlp_model, &gp_dataset_array[training_count], g_dataset_count - training_count);
+    trace_record("train_mlp_model", start_ns);
+
+    // the main thread only uses the networks and their results after it sees this flag
+    __atomic_store_n(&g_mlp_trained, true, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+/*
+Trains the random forest and calculates the results shown in the settings, on its training thread
+*/
+void *train_forest_model(void *argument)
+{
+    (void)argument;
+    unsigned long long start_ns = get_monotonic_ns();
+    int training_count = ceil(g_dataset_count * TRAINING_DATA_WEIGHT);
+
+    train_random_forest(&g_random_forest, gp_dataset_array, training_count, g_session_seed);
+    g_forest_confusion_matrix = evaluate_random_forest(&g_random_forest, &gp_dataset_array[training_count], g_dataset_count - training_count, &g_forest_roc_curve);
+    trace_record("train_forest_model", start_ns);
+
+    // the main thread only uses the forest and its results after it sees this flag
+    __atomic_store_n(&g_forest_trained, true, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+/*
+Starts training the model of the gamemode on a background thread if it has not been started yet, called once the startup loader has finished
+The model is trained on the calling thread if a thread cannot be created
+*/
+void start_model_training(Gamemode gamemode)
+{
+    void *(*train_model)(void *argument) = NULL;
+
+    if (gamemode == AI_KNN)
+        train_model = train_knn_model;
+    else if (gamemode == AI_MLP)
+        train_model = train_mlp_model;
+    else if (gamemode == AI_FOREST)
+        train_model = train_forest_model;
+
+    if (train_model == NULL || g_model_training_thread_started[gamemode] || is_model_trained(gamemode))
+        return;
+
+    // the dataset is shuffled on the main thread, so that the training threads only read it
+    prepare_ml_dataset();
+    if (pthread_create(&g_model_training_threads[gamemode], NULL, train_model, NULL) == 0)
+        g_model_training_thread_started[gamemode] = true;
+    else
+        train_model(NULL);
+}
+
+/*
+Returns whether the model of the gamemode can be used, gamemodes without a model trained in the background always return true
+*/
+bool is_model_trained(Gamemode gamemode)
+{
+    switch (gamemode)
+    {
+    case AI_KNN:
+        return __atomic_load_n(&g_knn_trained, __ATOMIC_ACQUIRE);
+    case AI_MLP:
+        return __atomic_load_n(&g_mlp_trained, __ATOMIC_ACQUIRE);
+    case AI_FOREST:
+        return __atomic_load_n(&g_forest_trained, __ATOMIC_ACQUIRE);
+    default:
+        return true;
+    }
+}
+
+/*
+Returns whether the model of any gamemode is still being trained in the background
+*/
+bool is_model_training()
+{
+    for (int gamemode = 0; gamemode < GAMEMODE_COUNT; gamemode++)
+        if (g_model_training_thread_started[gamemode] && !is_model_trained(gamemode))
+            return true;
+
+    return false;
+}
+
+/*
+Waits for every model training thread to finish, called before the program exits
+*/
+void join_model_training_threads()
+{
+    for (int gamemode = 0; gamemode < GAMEMODE_COUNT; gamemode++)
+        if (g_model_training_thread_started[gamemode])
+        {
+            pthread_join(g_model_training_threads[gamemode], NULL);
+            g_model_training_thread_started[gamemode] = false;
+        }
+}
+
+/*
+Loads the textures of the game and clears the analysis table the first time a game is started, so they are not loaded before the menu is shown
+*/
+void load_game_assets()
+{
+    if (g_cross_circle_texture.id != 0)
+        return;
+
+    // load the texture for the cross and circle
+    STARTUP_CALL("LoadTexture", false,
+                 Image image = load_packed_image(TEXTURE_FILE_PATH);
+                 g_cross_circle_texture = LoadTextureFromImage(image);
+                 UnloadImage(image));
+    // create the layer that the board is cached in, it covers the grid below the text ui
+    STARTUP_CALL("LoadRenderTexture", false, g_board_layer = LoadRenderTexture(SCREEN_WIDTH, SCREEN_HEIGHT));
+    g_board_layer_dirty = true;
+    // the analysis table is cleared here so that the first frame with the heatmap does not touch every page of it
+    STARTUP_CALL("analysis_init", false, analysis_init(&g_analysis, COLUMN, ANALYSIS_TABLE_BITS));
+}
+
+/*
+Prints the time of every startup phase in the order they finished, with the time since the process started
+Printed once the first frame has been drawn and the startup loader has finished
+*/
+void print_startup_report()
+{
+    int phase_count = g_startup_phase_count < STARTUP_MAX_PHASES ? g_startup_phase_count : STARTUP_MAX_PHASES;
+
+    printf("Startup report\n");
+    printf("%-24s %-10s %10s %10s\n", "phase", "thread", "start ms", "time ms");
+    for (int i = 0; i < phase_count; i++)
+        printf("%-24s %-10s %10.2f %10.2f\n", g_startup_phases[i].name, g_startup_phases[i].background ? "background" : "main",
+               g_startup_phases[i].start_ns / 1e6, g_startup_phases[i].duration_ns / 1e6);
+}
+
+/*
+Reads a whole file into memory that is freed with free(), used by the resource packer, the file data callback and the replay files
+Returns NULL if the file cannot be opened, its size cannot be found, it does not fit in memory or it cannot be read completely
+*/
+unsigned char *read_whole_file(const char *file_name, size_t *size)
+{
+    FILE *file = fopen(file_name, "rb");
+    if (file == NULL)
+        return NULL;
+
+    // ftell returns -1 for files it cannot seek in, and for files larger than a long on platforms where a long is 32 bits
+    long file_size = -1;
+    if (fseek(file, 0, SEEK_END) == 0)
+        file_size = ftell(file);
+    if (file_size < 0 || fseek(file, 0, SEEK_SET) != 0)
+    {
+        fclose(file);
+        return NULL;
+    }
+
+    unsigned char *data = malloc(file_size > 0 ? (size_t)file_size : 1);
+    if (data == NULL || fread(data, 1, file_size, file) != (size_t)file_size || ferror(file))
+    {
+        free(data);
+        fclose(file);
+        return NULL;
+    }
+
+    fclose(file);
+    *size = file_size;
+    return data;
+}
+
+/*
+Decompresses the resource pack that is compiled into the game, when the game is built with EMBED_RESOURCES
+raylib then loads every file through load_packed_file_data(), so the files are read from the pack instead of the disk
+*/
+void load_resource_pack()
+{
+#if defined(EMBED_RESOURCES)
+    int pack_size = 0;
+    gp_resource_pack = DecompressData(RESOURCE_PACK, RESOURCE_PACK_SIZE, &pack_size);
+
+    const Resource_Pack_Header *header = (const Resource_Pack_Header *)gp_resource_pack;
+    if (gp_resource_pack == NULL || pack_size < (int)sizeof(Resource_Pack_Header) ||
+        memcmp(header->magic, RESOURCE_PACK_MAGIC, sizeof(header->magic)) != 0 || header->version != RESOURCE_PACK_VERSION)
+    {
+        printf("Error decompressing the embedded resource pack\n");
+        exit(1);
+    }
+
+    SetLoadFileDataCallback(load_packed_file_data);
+#endif
+}
+
+/*
+Returns the data of a file in the resource pack and writes its size, the data stays valid until the game exits
+Returns NULL if there is no resource pack or the file is not in it
+*/
+const unsigned char *find_packed_resource(const char *file_name, int *size)
+{
+    if (gp_resource_pack == NULL)
+        return NULL;
+
+    const Resource_Pack_Header *header = (const Resource_Pack_Header *)gp_resource_pack;
+    const Resource_Entry *entries = (const Resource_Entry *)(header + 1);
+
+    for (int i = 0; i < header->count; i++)
+        if (strcmp(entries[i].name, file_name) == 0)
+        {
+            *size = entries[i].size;
+            return gp_resource_pack + entries[i].offset;
+        }
+
+    return NULL;
+}
+
+/*
+File data callback of raylib, returns a copy of a packed file or reads it from the disk if it is not in the pack
+raylib frees the data with free() once it is done with it
+*/
+unsigned char *load_packed_file_data(const char *file_name, unsigned int *bytes_read)
+{
+    int size = 0;
+    const unsigned char *packed_data = find_packed_resource(file_name, &size);
+    unsigned char *data = NULL;
+
+    if (packed_data != NULL)
+    {
+        data = malloc(size > 0 ? size : 1);
+        if (data != NULL)
+            memcpy(data, packed_data, size);
+    }
+    else
+    {
+        // raylib counts the bytes of a file with an unsigned int, larger files are not loaded
+        size_t file_size = 0;
+        data = read_whole_file(file_name, &file_size);
+        if (data != NULL && file_size > UINT_MAX)
+        {
+            free(data);
+            data = NULL;
+        }
+        size = file_size;
+    }
+
+    *bytes_read = data != NULL ? size : 0;
+    return data;
+}
+
+/*
+Loads the style of the gui from the resource pack, or from GUI_FILE_PATH if it is not packed
+*/
+void load_gui_style()
+{
+    int size = 0;
+    const unsigned char *packed_data = find_packed_resource(GUI_FILE_PATH, &size);
+
+    // the packed style is binary, which is the only format raygui can load from memory
+    if (packed_data != NULL)
+        GuiLoadStyleFromMemory(packed_data, size);
+    else
+        GuiLoadStyle(GUI_FILE_PATH);
+}
+
+/*
+Packs every file of RESOURCE_PACK_FILES into one blob, compresses it with DEFLATE and writes it as a C header
+The header is compiled into the game when it is built with EMBED_RESOURCES
+*/
+void write_resource_pack(char file_name[])
+{
+    int file_count = sizeof(RESOURCE_PACK_FILES) / sizeof(RESOURCE_PACK_FILES[0]);
+    unsigned char *file_data[sizeof(RESOURCE_PACK_FILES) / sizeof(RESOURCE_PACK_FILES[0])];
+    size_t file_sizes[sizeof(RESOURCE_PACK_FILES) / sizeof(RESOURCE_PACK_FILES[0])];
+
+    // the files are placed after the header and the entries, each aligned so that their values can be read in place
+    size_t pack_size = sizeof(Resource_Pack_Header) + sizeof(Resource_Entry) * file_count;
+    for (int i = 0; i < file_count; i++)
+    {
+        file_data[i] = read_whole_file(RESOURCE_PACK_FILES[i], &file_sizes[i]);
+        if (file_data[i] == NULL || strlen(RESOURCE_PACK_FILES[i]) >= RESOURCE_NAME_SIZE)
+        {
+            printf("Error reading resource %s\n", RESOURCE_PACK_FILES[i]);
+            exit(1);
+        }
+        pack_size = (pack_size + RESOURCE_ALIGNMENT - 1) / RESOURCE_ALIGNMENT * RESOURCE_ALIGNMENT + file_sizes[i];
+    }
+
+    // the entries and the compression of raylib count bytes with an int
+    if (pack_size > INT_MAX)
+    {
+        printf("Error packing the resources, %zu bytes is larger than a pack can hold\n", pack_size);
+        exit(1);
+    }
+
+    unsigned char *pack = calloc(pack_size, 1);
+    if (pack == NULL)
+    {
+        printf("Error allocating memory for the resource pack\n");
+        exit(1);
+    }
+
+    Resource_Pack_Header *header = (Resource_Pack_Header *)pack;
+    Resource_Entry *entries = (Resource_Entry *)(header + 1);
+    memcpy(header->magic, RESOURCE_PACK_MAGIC, sizeof(header->magic));
+    header->version = RESOURCE_PACK_VERSION;
+    header->count = file_count;
+
+    int offset = sizeof(Resource_Pack_Header) + sizeof(Resource_Entry) * file_count;
+    for (int i = 0; i < file_count; i++)
+    {
+        offset = (offset + RESOURCE_ALIGNMENT - 1) / RESOURCE_ALIGNMENT * RESOURCE_ALIGNMENT;
+        strcpy(entries[i].name, RESOURCE_PACK_FILES[i]);
+        entries[i].offset = offset;
+        entries[i].size = file_sizes[i];
+        memcpy(pack + offset, file_data[i], file_sizes[i]);
+        offset += file_sizes[i];
+        free(file_data[i]);
+    }
+
+    int compressed_size = 0;
+    unsigned char *compressed_pack = CompressData(pack, pack_size, &compressed_size);
+    FILE *header_file = fopen(file_name, "w");
+    if (compressed_pack == NULL || header_file == NULL)
+    {
+        printf("Error writing the resource pack to %s\n", file_name);
+        exit(1);
+    }
+
+    fprintf(header_file, "// resource pack of the game, generated by --pack-resources, do not edit\n");
+    fprintf(header_file, "#define RESOURCE_PACK_SIZE %d\n\n", compressed_size);
+    fprintf(header_file, "const unsigned char RESOURCE_PACK[RESOURCE_PACK_SIZE] = {");
+    for (int i = 0; i < compressed_size; i++)
+        fprintf(header_file, "%s0x%02x,", i % 16 == 0 ? "\n    " : " ", compressed_pack[i]);
+    fprintf(header_file, "\n};\n");
+    fclose(header_file);
+
+    printf("Packed %d files, %zu bytes compressed to %d bytes, written to %s\n", file_count, pack_size, compressed_size, file_name);
+    MemFree(compressed_pack);
+    free(pack);
+}
+
+/*
+Loads an image from the resource pack, or from the file if it is not packed
+*/
+Image load_packed_image(const char *file_name)
+{
+    int size = 0;
+    const unsigned char *packed_data = find_packed_resource(file_name, &size);
+
+    if (packed_data != NULL)
+        return LoadImageFromMemory(GetFileExtension(file_name), packed_data, size);
+
+    return LoadImage(file_name);
+}
+
+/*
+Returns whether the screen changes without any input: the spectator view, the game over countdown, the AI taking its turn,
+the performance HUD, or the settings while the naive bayes model is trained
+*/
+bool is_animating()
+{
+    // the spectator games move by themselves, and the performance HUD measures every frame of the game
+    if (g_current_state == SPECTATE || (g_current_state == GAME && g_perf_hud_visible))
+        return true;
+
+    // the analysis heatmap keeps searching deeper until its values are exact
+    if (g_current_state == GAME && g_analysis_visible && !g_analysis.finished)
+        return true;
+
+    // the settings show the naive bayes results as soon as the startup loader has trained the model
+    if (g_current_state == SETTING && !is_startup_loader_finished())
+        return true;
+
+    // the settings show the results of the other models, and the game lets their AI move, as soon as their training has finished
+    if ((g_current_state == SETTING || g_current_state == GAME) && is_model_training())
+        return true;
+
+    if (g_current_state != GAME)
+        return false;
+
+    // the countdown is shown until the game changes to the game over screen
+    if (gp_winner != NULL || is_board_full())
+        return true;
+
+    return gp_current_player != NULL && gp_current_player->type == PLAYER_AI;
+}
+
+/*
+Makes sure the next frame_count frames are drawn without waiting for input
+Used when something changes the screen outside of an input event
+*/
+void request_frames(int frame_count)
+{
+    if (frame_count > g_requested_frames)
+        g_requested_frames = frame_count;
+}
+
+/*
+Applies the frame rate cap chosen in the settings, and turns on raylib's event waiting when nothing is animating
+While waiting, EndDrawing() blocks until there is input, so static screens do not use the CPU or GPU
+*/
+void update_frame_pacing()
+{
+    if (FPS_CAPS[g_fps_cap_option] != g_applied_fps_cap)
+    {
+        g_applied_fps_cap = FPS_CAPS[g_fps_cap_option];
+        SetTargetFPS(g_applied_fps_cap);
+    }
+
+    bool wait_for_events = g_requested_frames == 0 && !is_animating();
+    if (g_requested_frames > 0)
+        g_requested_frames--;
+
+    if (wait_for_events != g_waiting_for_events)
+    {
+        if (wait_for_events)
+            EnableEventWaiting();
+        else
+            DisableEventWaiting();
+        g_waiting_for_events = wait_for_events;
+    }
+}
+
+/*
+Returns the time in nanoseconds from a monotonic clock, which only moves forward and does not depend on the CPU time of the process
+Every timer of the game and the tools is measured with this clock
+*/
+unsigned long long get_monotonic_ns()
+{
+    struct timespec time;
+
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (unsigned long long)time.tv_sec * 1000000000ULL + time.tv_nsec;
+}
+
+/*
+Returns the monotonic time in seconds, used to measure how long the headless tools take
+*/
+double get_monotonic_time()
+{
+    return get_monotonic_ns() / 1e9;
+}
+
+/*
+Returns the number of seconds since start_ns, a time from get_monotonic_ns()
+*/
+double get_seconds_since(unsigned long long start_ns)
+{
+    return (get_monotonic_ns() - start_ns) / 1e9;
+}
+
+/*
+Returns the cpu time used by the calling thread in seconds, used to time work that shares the cores with other threads
+*/
+double get_thread_cpu_time()
+{
+    struct timespec time;
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+    return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+/*
+Returns the best move from an AI, and records how long it took in the trace and the performance HUD
+*/
+Move get_timed_ai_move(const char *name, Move (*get_best_move)())
+{
+    unsigned long long start_ns = get_monotonic_ns();
+    Move best_move = get_best_move();
+
+    trace_record(name, start_ns);
+    g_perf_stats.ai_ns += get_monotonic_ns() - start_ns;
+    return best_move;
+}
+
+/*
+Adds the time since the last frame to the rolling window and the histogram, and averages the update, render and AI time of the frame
+Called once at the start of every frame, nothing is allocated so it can run every frame
+*/
+void record_frame_stats()
+{
+    Perf_Stats *stats = &g_perf_stats;
+    unsigned long long now_ns = get_monotonic_ns();
+
+    if (stats->last_frame_ns != 0)
+    {
+        float frame_time = (now_ns - stats->last_frame_ns) / 1e6f;
+
+        // the frame that leaves the window is taken out of the histogram before the new frame is added
+        if (stats->frame_count == PERF_WINDOW_FRAMES)
+            stats->histogram[get_frame_time_bin(stats->frame_times[stats->frame_index])]--;
+        else
+            stats->frame_count++;
+
+        stats->frame_times[stats->frame_index] = frame_time;
+        stats->histogram[get_frame_time_bin(frame_time)]++;
+        stats->frame_index = (stats->frame_index + 1) % PERF_WINDOW_FRAMES;
+
+        // moving averages so that the numbers can be read while they change every frame
+        stats->update_time += (stats->update_ns / 1e6f - stats->update_time) * PERF_AVERAGE_WEIGHT;
+        stats->render_time += (stats->render_ns / 1e6f - stats->render_time) * PERF_AVERAGE_WEIGHT;
+        stats->ai_time += (stats->ai_ns / 1e6f - stats->ai_time) * PERF_AVERAGE_WEIGHT;
+    }
+
+    stats->last_frame_ns = now_ns;
+    stats->update_ns = stats->render_ns = stats->ai_ns = 0;
+
+    // the memory is read from the operating system a few times a second instead of every frame
+    if (now_ns - stats->memory_read_ns >= PERF_MEMORY_INTERVAL_NS)
+    {
+        stats->memory_bytes = get_memory_in_use();
+        stats->memory_read_ns = now_ns;
+    }
+}
+
+/*
+Returns the histogram bin of a frame time in milliseconds, the bins are log spaced so that both fast and slow frames are told apart
+Frames slower than the last bin return PERF_HISTOGRAM_BINS, which is counted apart from the bins
+*/
+int get_frame_time_bin(float frame_time)
+{
+    if (frame_time < PERF_HISTOGRAM_MIN_TIME)
+        return 0;
+
+    int bin = 1 + (int)(log2f(frame_time / PERF_HISTOGRAM_MIN_TIME) * PERF_HISTOGRAM_BINS_PER_OCTAVE);
+    return bin < PERF_HISTOGRAM_BINS ? bin : PERF_HISTOGRAM_BINS;
+}
+
+/*
+Returns the upper edge of a histogram bin in milliseconds
+*/
+float get_frame_time_bin_edge(int bin)
+{
+    return PERF_HISTOGRAM_MIN_TIME * exp2f((float)bin / PERF_HISTOGRAM_BINS_PER_OCTAVE);
+}
+
+/*
+Returns the frame time in milliseconds that the given share of the frames in the window are faster than
+Read from the histogram, so the result is the upper edge of a bin
+If the percentile is among the frames slower than every bin, the slowest frame of the window is returned instead
+*/
+float get_frame_time_percentile(float percentile)
+{
+    int target_count = ceil(g_perf_stats.frame_count * percentile);
+    int count = 0;
+
+    for (int bin = 0; bin < PERF_HISTOGRAM_BINS; bin++)
+    {
+        count += g_perf_stats.histogram[bin];
+        if (count >= target_count)
+            return get_frame_time_bin_edge(bin);
+    }
+
+    float slowest_time = 0;
+    for (int i = 0; i < g_perf_stats.frame_count; i++)
+        slowest_time = fmaxf(slowest_time, g_perf_stats.frame_times[i]);
+
+    return slowest_time;
+}
+
+/*
+Returns the number of draw calls in the active render batch that have vertices
+Called before EndDrawing(), when the batch holds everything drawn since BeginDrawing() unless it was flushed early
+*/
+int count_draw_calls()
+{
+    int draw_calls = 0;
+
+    for (int i = 0; i < g_perf_batch.drawCounter; i++)
+        if (g_perf_batch.draws[i].vertexCount > 0)
+            draw_calls++;
+
+    return draw_calls;
+}
+
+/*
+Returns the memory used by the process in bytes, the resident set size from /proc on Linux and the task info on macOS
+Returns -1 if the memory cannot be read on this platform
+*/
+long long get_memory_in_use()
+{
+#if defined(__linux__)
+    // read with a buffer on the stack instead of fopen so that nothing is allocated
+    char text[64] = {0};
+    int file = open("/proc/self/statm", O_RDONLY);
+    if (file < 0)
+        return -1;
+
+    ssize_t length = read(file, text, sizeof(text) - 1);
+    close(file);
+    if (length <= 0)
+        return -1;
+
+    // the second number is the number of resident pages
+    char *resident_pages = strchr(text, ' ');
+    return resident_pages ? strtoll(resident_pages + 1, NULL, 10) * sysconf(_SC_PAGESIZE) : -1;
+#elif defined(__APPLE__)
+    struct mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) != KERN_SUCCESS)
+        return -1;
+    return info.resident_size;
+#else
+    return -1;
+#endif
+}
+
+/*
+Draws the performance HUD over the top left of the board, the FPS, the frame time percentiles and histogram,
+the update, render and AI time, the draw calls of the last frame and the memory in use
+*/
+void render_perf_hud()
+{
+    const Perf_Stats *stats = &g_perf_stats;
+    int x_coord = 10;
+    int y_coord = UI_OFFSET + 10;
+
+    DrawRectangle(x_coord, y_coord, PERF_HUD_WIDTH, PERF_HUD_HEIGHT, (Color){0, 0, 0, 170});
+    DrawText(TextFormat("FPS %d", GetFPS()), x_coord + 10, y_coord + 10, 20, RAYWHITE);
+    DrawText(TextFormat("p50 %.1f  p95 %.1f  p99 %.1f ms", get_frame_time_percentile(0.5f), get_frame_time_percentile(0.95f), get_frame_time_percentile(0.99f)), x_coord + 10, y_coord + 35, 16, RAYWHITE);
+    DrawText(TextFormat("update %.2f  render %.2f  AI %.2f ms", stats->update_time, stats->render_time, stats->ai_time), x_coord + 10, y_coord + 55, 16, RAYWHITE);
+    DrawText(TextFormat("draw calls %d  frames over %.0f ms %d", stats->draw_calls, get_frame_time_bin_edge(PERF_HISTOGRAM_BINS - 1), stats->histogram[PERF_HISTOGRAM_BINS]), x_coord + 10, y_coord + 75, 16, RAYWHITE);
+    if (stats->memory_bytes >= 0)
+        DrawText(TextFormat("memory %.1f MB", stats->memory_bytes / (1024.0 * 1024.0)), x_coord + 10, y_coord + 95, 16, RAYWHITE);
+    else
+        DrawText("memory n/a", x_coord + 10, y_coord + 95, 16, RAYWHITE);
+
+    // draw the histogram of the frame times, each bar is the share of the window in a bin, the frames over the last bin are only counted above
+    int histogram_height = PERF_HUD_HEIGHT - 130;
+    int histogram_bottom = y_coord + PERF_HUD_HEIGHT - 10;
+    int bar_width = (PERF_HUD_WIDTH - 20) / PERF_HISTOGRAM_BINS;
+    for (int bin = 0; bin < PERF_HISTOGRAM_BINS && stats->frame_count > 0; bin++)
+    {
+        int bar_height = (float)stats->histogram[bin] / stats->frame_count * histogram_height;
+        DrawRectangle(x_coord + 10 + bin * bar_width, histogram_bottom - bar_height, bar_width - 1, bar_height, get_frame_time_bin_edge(bin) <= 1000.0f / 60 ? GREEN : ORANGE);
+    }
+}
+
+/*
+Marks the trace buffer of a thread that has exited as free, so that the next thread can reuse it
+Called by pthread for every thread that has acquired a buffer
+*/
+void release_trace_buffer(void *buffer)
+{
+    __atomic_store_n(&((Trace_Buffer *)buffer)->owned, false, __ATOMIC_RELEASE);
+}
+
+/*
+Creates the key that releases the trace buffer of a thread when it exits, ran once by pthread_once
+*/
+void create_trace_buffer_key()
+{
+    pthread_key_create(&g_trace_buffer_key, release_trace_buffer);
+}
+
+/*
+Returns the trace buffer of the calling thread, taking a free buffer from the pool on the first call
+Returns NULL if every buffer of the pool is owned by a running thread, the events of the thread are then dropped
+*/
+Trace_Buffer *acquire_trace_buffer()
+{
+    if (gp_thread_trace_buffer != NULL)
+        return gp_thread_trace_buffer;
+
+    pthread_once(&g_trace_buffer_key_once, create_trace_buffer_key);
+
+    for (int i = 0; i < TRACE_MAX_BUFFERS; i++)
+    {
+        Trace_Buffer *buffer = __atomic_load_n(&gp_trace_buffers[i], __ATOMIC_ACQUIRE);
+
+        // allocate the buffer of an empty slot, another thread may fill the slot first
+        if (buffer == NULL)
+        {
+            Trace_Buffer *new_buffer = calloc(1, sizeof(Trace_Buffer));
+            if (new_buffer == NULL)
+                return NULL;
+
+            new_buffer->owned = true;
+            if (__atomic_compare_exchange_n(&gp_trace_buffers[i], &buffer, new_buffer, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+                buffer = new_buffer;
+            else
+            {
+                free(new_buffer);
+                bool owned = false;
+                if (!__atomic_compare_exchange_n(&buffer->owned, &owned, true, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+                    continue;
+            }
+        }
+        else
+        {
+            bool owned = false;
+            if (!__atomic_compare_exchange_n(&buffer->owned, &owned, true, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+                continue;
+        }
+
+        g_thread_trace_id = __atomic_fetch_add(&g_trace_thread_count, 1, __ATOMIC_RELAXED);
+        gp_thread_trace_buffer = buffer;
+        pthread_setspecific(g_trace_buffer_key, buffer);
+        return buffer;
+    }
+
+    return NULL;
+}
+
+/*
+Records an event from start_ns until now into the trace buffer of the calling thread, name must be a string literal
+Only the owning thread writes a buffer, so the count is published with a release store instead of a lock
+When the buffer is full, the oldest event is overwritten
+*/
+void trace_record(const char *name, unsigned long long start_ns)
+{
+    unsigned long long end_ns = get_monotonic_ns();
+    Trace_Buffer *buffer = acquire_trace_buffer();
+    if (buffer == NULL)
+        return;
+
+    unsigned long long write_count = buffer->write_count;
+    buffer->events[write_count % TRACE_BUFFER_SIZE] = (Trace_Event){name, start_ns, end_ns - start_ns, g_thread_trace_id};
+    __atomic_store_n(&buffer->write_count, write_count + 1, __ATOMIC_RELEASE);
+}
+
+/*
+Writes the events of every trace buffer into a file as Chrome trace JSON, which can be opened in Perfetto or chrome://tracing
+The buffers keep being written while they are copied, events that may have been overwritten during the copy are skipped
+*/
+void write_trace_file(char file_name[])
+{
+    Trace_Event *events = malloc(sizeof(Trace_Event) * TRACE_BUFFER_SIZE * TRACE_MAX_BUFFERS);
+    int event_count = 0;
+
+    if (events == NULL)
+    {
+        printf("Error allocating memory for the trace events\n");
+        return;
+    }
+
+    for (int i = 0; i < TRACE_MAX_BUFFERS; i++)
+    {
+        Trace_Buffer *buffer = __atomic_load_n(&gp_trace_buffers[i], __ATOMIC_ACQUIRE);
+        if (buffer == NULL)
+            continue;
+
+        unsigned long long end = __atomic_load_n(&buffer->write_count, __ATOMIC_ACQUIRE);
+        unsigned long long start = end > TRACE_BUFFER_SIZE ? end - TRACE_BUFFER_SIZE : 0;
+        for (unsigned long long j = start; j < end; j++)
+            events[event_count + j - start] = buffer->events[j % TRACE_BUFFER_SIZE];
+
+        // the events before the last TRACE_BUFFER_SIZE events at the end of the copy may have been overwritten,
+        // and the slot of event copied_end may be half written, as it is the slot of event copied_end - TRACE_BUFFER_SIZE
+        unsigned long long copied_end = __atomic_load_n(&buffer->write_count, __ATOMIC_ACQUIRE);
+        unsigned long long valid_start = copied_end + 1 > TRACE_BUFFER_SIZE ? copied_end + 1 - TRACE_BUFFER_SIZE : 0;
+        if (valid_start > start)
+        {
+            int skipped_count = valid_start < end ? valid_start - start : end - start;
+            memmove(&events[event_count], &events[event_count + skipped_count], sizeof(Trace_Event) * (end - start - skipped_count));
+            event_count -= skipped_count;
+        }
+        event_count += end - start;
+    }
+
+    FILE *trace_file = fopen(file_name, "w");
+    if (!trace_file)
+    {
+        printf("Error opening file %s\n", file_name);
+        free(events);
+        return;
+    }
+
+    // the times are written in microseconds from the first event, which is what the trace viewers expect
+    unsigned long long origin_ns = ULLONG_MAX;
+    for (int i = 0; i < event_count; i++)
+        if (events[i].start_ns < origin_ns)
+            origin_ns = events[i].start_ns;
+
+    fprintf(trace_file, "{\"traceEvents\":[\n");
+    for (int i = 0; i < event_count; i++)
+        fprintf(trace_file, "{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d},\n",
+                events[i].name, (events[i].start_ns - origin_ns) / 1e3, events[i].duration_ns / 1e3, events[i].thread_id);
+    // name the threads, the main thread is the first thread to record an event
+    int thread_count = __atomic_load_n(&g_trace_thread_count, __ATOMIC_RELAXED);
+    for (int i = 0; i < thread_count; i++)
+        fprintf(trace_file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s %d\"}}%s\n",
+                i, i == 0 ? "main" : "worker", i, i + 1 < thread_count ? "," : "");
+    fprintf(trace_file, "],\"displayTimeUnit\":\"ms\"}\n");
+
+    fclose(trace_file);
+    printf("Wrote %d trace events to %s\n", event_count, file_name);
+    free(events);
+}
+
+/*
+Draws the grid lines and every tile into g_board_layer if the board has changed since the layer was last drawn
+The layer does not include the text ui offset, it is moved down when it is drawn
+*/
+void update_board_layer()
+{
+    if (!g_board_layer_dirty)
+        return;
+
+    BeginTextureMode(g_board_layer);
+    ClearBackground(BACKGROUND_COLOUR);
+    // nested loop to go through every cell in the grid
+    for (int i = 0; i < ROW; i++)
+        for (int j = 0; j < COLUMN; j++)
+        {
+            // calculate the coordinates for each tile
+            int x_coord = j * CELL_WIDTH;
+            int y_coord = i * CELL_HEIGHT;
+            // draw rectangles for each cell
+            DrawRectangleLines(x_coord, y_coord, CELL_WIDTH, CELL_HEIGHT, TITLE_COLOUR);
+            // we render each tile
+            render_tile(x_coord, y_coord, g_grid[i][j]);
+        }
+    EndTextureMode();
+
+    g_board_layer_dirty = false;
+}
+
+// main grid rendering function
+void render_grid()
+{
+    // draw the cached board as one quad, render textures are stored upside down so the source height is negative
+    DrawTextureRec(g_board_layer.texture, (Rectangle){0, 0, SCREEN_WIDTH, -SCREEN_HEIGHT}, (Vector2){0, UI_OFFSET}, WHITE);
+
+    // draw the value of every empty cell over the board while the analysis is turned on
+    if (g_analysis_visible && gp_winner == NULL && !is_board_full())
+        render_analysis();
+
+    // if the game is over, we draw the line and also show a countdown
+    if (gp_winner != NULL || is_board_full())
+    {
+        // if board is full and no winner, dont draw line, however if board is full but winner is found, draw line, else draw line if winner is found
+        if (!is_board_full() || gp_winner != NULL)
+            render_line(g_winner_start, g_winner_end, WIN_LINE_THICKNESS);
+        // get the time left from the time the game ended
+        double remaining_time = GAME_END_DELAY - get_seconds_since(g_game_end_ns);
+        // if the delay has passed, we change the state to gameover
+        if (remaining_time <= 0)
+        {
+            remaining_time = 0;
+            set_current_state(GAMEOVER);
+        }
+        // draw the countdown timer
+        const char *countdown_timer = TextFormat("Game will end in %.1f", remaining_time);
+        DrawText(countdown_timer, SCREEN_WIDTH / 2 - MeasureText(countdown_timer, 50) / 2, SCREEN_HEIGHT / 2 + UI_OFFSET, TITLE_FONT_SIZE, TITLE_COLOUR);
+    }
+}
+
+/*
+Function to render tile individual tiles
+*/
+void render_tile(int x_coord, int y_coord, Tile tile)
+{
+    // create a rectangle variable for where we want our tile to be
+    Rectangle destination = {x_coord, y_coord, CELL_WIDTH, CELL_HEIGHT};
+    Rectangle source;
+
+    // switch case to render the tile according to the tile type
+    switch (tile)
+    {
+    case CROSS:
+        source = (Rectangle){0, 0, 100, 100};
+        DrawTexturePro(g_cross_circle_texture, source, destination, (Vector2){0, 0}, 0, WHITE);
+        break;
+    case CIRCLE:
+        source = (Rectangle){100, 0, 100, 100};
+        DrawTexturePro(g_cross_circle_texture, source, destination, (Vector2){0, 0}, 0, WHITE);
+        break;
+    case EMPTY:
+        break;
+    }
+}
+
+/*
+function to render the text ui at the top of game screen
+*/
+void render_text_ui()
+{
+    // get the coord at half of the screen
+    int x_coord = SCREEN_WIDTH / 2;
+    // get the coord at 1/6 of the blank area
+    int y_coord = UI_OFFSET / 6;
+    int font_size = 40;
+    char top_text[30] = "-";
+
+    // if the game is over, print respective title
+    if (gp_winner != NULL || is_board_full())
+    {
+        if (gp_winner == &g_player_one)
+            strcpy(top_text, "Player 1 wins!");
+        else if (gp_winner == &g_player_two)
+            strcpy(top_text, "Player 2 wins!");
+        else if (is_board_full())
+            strcpy(top_text, "Draw!");
+    }
+    else // if game is still going on print the current player turn
+    {
+        if (gp_current_player == &g_player_one)
+            strcpy(top_text, "Player 1's turn");
+        else if (gp_current_player && !is_model_trained(g_current_gamemode))
+            strcpy(top_text, "Player 2 is training");
+        else if (gp_current_player)
+            strcpy(top_text, "Player 2's turn");
+    }
+
+    // draw the text
+    DrawText(top_text, x_coord - MeasureText(top_text, font_size) / 2, y_coord, font_size, TITLE_COLOUR);
+}
+
+/*
+Function to render the game over line using a start and end position and a thickness
+*/
+void render_line(Move start, Move end, float thickness)
+{
+    Vector2 start_position = {start.column * CELL_WIDTH + CELL_WIDTH / 2, start.row * CELL_HEIGHT + CELL_HEIGHT / 2 + UI_OFFSET};
+    Vector2 end_position = {end.column * CELL_WIDTH + CELL_WIDTH / 2, end.row * CELL_HEIGHT + CELL_HEIGHT / 2 + UI_OFFSET};
+    static const Color red_translucent = (Color){255, 0, 0, 150};
+    DrawLineEx(start_position, end_position, thickness, red_translucent);
+}
+
+/*
+populate the grid according to tile input
+*/
+void populate_grid(Tile tile)
+{
+    for (int i = 0; i < ROW; i++)
+        for (int j = 0; j < COLUMN; j++)
+            g_grid[i][j] = tile;
+    g_board_layer_dirty = true;
+}
+
+/*
+Sets the desired tile at the desired row and column
+Use this function to set the tile instead of directly accessing the g_grid array
+*/
+bool set_tile(int row, int col, Tile tile)
+{
+    if (is_tile_placeable(row, col))
+    {
+        g_grid[row][col] = tile;
+        g_board_layer_dirty = true;
+        record_replay_move(row, col);
+        check_win_condition();
+        // if this move finished the game with a win or a draw, start the countdown, learn from the final board and save the replay
+        if (gp_winner != NULL || is_board_full())
+        {
+            g_game_end_ns = get_monotonic_ns();
+            learn_finished_game();
+            save_replay();
+        }
+        return true;
+    }
+    else
+        return false;
+}
+
+/*
+Checks if the desired tile is placeable
+*/
+bool is_tile_placeable(int row, int col)
+{
+    if (g_grid[row][col] == EMPTY)
+        return true;
+    else
+        return false;
+}
+
+/*
+Returns 1 if the board is full, else return 0
+*/
+int is_board_full()
+{
+    for (int i = 0; i < ROW; i++)
+    {
+        for (int j = 0; j < COLUMN; j++)
+        {
+            if (g_grid[i][j] == EMPTY)
+            {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+/*
+Evaluate the current board and return 1 if g_player_two has won, -1 if g_player_one has won.
+Reset the gp_winner pointer to NULL after evaluation. Mainly used for minimax algorithm.
+*/
+int evaluate()
+{
+    check_win_condition();
+
+    // if g_player_two has won, return 1, reset gp_winner to NULL
+    if (gp_winner == &g_player_two)
+    {
+        gp_winner = NULL;
+        return 1;
+    }
+    else if (gp_winner == &g_player_one)
+    {
+        gp_winner = NULL;
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+Returns a boolean value if the current grid is a winning condition and updates gp_winner
+Variables g_winner_start and g_winner_end are the start and end position of the winning line
+It returns a boolean if there is a win, but also updates the gp_winner pointer to the winner
+*/
+bool check_win_condition()
+{
+    Tile temp;
+    // loop through each row, and compare columns
+    // algo to check each row
+    for (int i = 0; i < ROW; i++)
+        for (int j = 0; j < COLUMN; j++)
+        {
+            if (j == 0)
+            {
+                temp = g_grid[i][j];
+                g_winner_start = (Move){i, j};
+                continue;
+            }
+            else if (temp != g_grid[i][j])
+            {
+                temp = EMPTY;
+                break;
+            }
+            else if (j == COLUMN - 1)
+            {
+                if (g_player_one.tile == temp)
+                {
+                    gp_winner = &g_player_one;
+                    g_winner_end = (Move){i, j};
+                    return true;
+                }
+                else if (g_player_two.tile == temp)
+                {
+                    gp_winner = &g_player_two;
+                    g_winner_end = (Move){i, j};
+                    return true;
+                }
+            }
+        }
+
+    // loop through each column, and compare rows
+    // algo to check each column
+    for (int i = 0; i < COLUMN; i++)
+        for (int j = 0; j < ROW; j++)
+        {
+            if (j == 0)
+            {
+                temp = g_grid[j][i];
+                g_winner_start = (Move){j, i};
+                continue;
+            }
+            else if (temp != g_grid[j][i])
+            {
+                temp = EMPTY;
+                break;
+            }
+            else if (j == ROW - 1)
+            {
+                if (g_player_one.tile == temp)
+                {
+                    gp_winner = &g_player_one;
+                    g_winner_end = (Move){j, i};
+                    return true;
+                }
+                else if (g_player_two.tile == temp)
+                {
+                    gp_winner = &g_player_two;
+                    g_winner_end = (Move){j, i};
+                    return true;
+                }
+            }
+        }
+
+    // algo to check top left to bottom right diagonal
+    for (int i = 0; i < ROW; i++)
+    {
+        if (i == 0)
+        {
+            temp = g_grid[i][i];
+            g_winner_start = (Move){i, i};
+            continue;
+        }
+        else if (temp != g_grid[i][i])
+        {
+            temp = EMPTY;
+            break;
+        }
+        else if (i == ROW - 1)
+        {
+            if (g_player_one.tile == temp)
+            {
+                gp_winner = &g_player_one;
+                g_winner_end = (Move){i, i};
+                return true;
+            }
+            else if (g_player_two.tile == temp)
+            {
+                gp_winner = &g_player_two;
+                g_winner_end = (Move){i, i};
+                return true;
+            }
+        }
+    }
+
+    // algo to check bottom left to top right diagonal
+    for (int i = 0; i < ROW; i++)
+    {
+        if (i == 0)
+        {
+            temp = g_grid[ROW - 1 - i][i];
+            g_winner_start = (Move){ROW - 1 - i, i};
+            continue;
+        }
+        else if (temp != g_grid[ROW - 1 - i][i])
+        {
+            temp = EMPTY;
+            break;
+        }
+        else if (i == ROW - 1)
+        {
+            if (g_player_one.tile == temp)
+            {
+                gp_winner = &g_player_one;
+                g_winner_end = (Move){ROW - 1 - i, i};
+                return true;
+            }
+            else if (g_player_two.tile == temp)
+            {
+                gp_winner = &g_player_two;
+                g_winner_end = (Move){ROW - 1 - i, i};
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+/*
+Recursive function that calculates the minimax value of the current board state,
+implemented with alpha-beta pruning.
+*/
+int mini_max(int depth, int is_max, int max_depth, int alpha, int beta)
+{
+    int score = evaluate();
+
+    if (score != 0)
+        return score;
+    if (is_board_full() || depth == max_depth)
+        return 0;
+
+    // initalize a best value base on the current player (max or min)
+    int best_val = is_max ? -1000 : 1000;
+
+    // loop through the board cells
+    for (int i = 0; i < ROW; i++)
+    {
+        for (int j = 0; j < COLUMN; j++)
+        {
+            if (g_grid[i][j] == EMPTY)
+            {
+                // temporarily set the cell with the current player's tile
+                g_grid[i][j] = is_max ? g_player_two.tile : g_player_one.tile;
+
+                // recursively calculate the minimax value
+                int move_val = mini_max(depth + 1, !is_max, max_depth, alpha, beta);
+
+                // update the best value based on the current player (max or min)
+                best_val = is_max ? fmax(best_val, move_val) : fmin(best_val, move_val);
+
+                // undo the move (backtrack)
+                g_grid[i][j] = EMPTY;
+
+                // alpha-beta pruning codes
+                if (is_max)
+                {
+                    alpha = fmax(alpha, move_val);
+                }
+                else
+                {
+                    beta = fmin(beta, move_val);
+                }
+
+                /*
+                if beta is less than or equal to alpha, break out of the loop
+                as the rest of the moves will not be considered
+                */
+                if (beta <= alpha)
+                {
+                    break;
+                }
+            }
+        }
+    }
+
+    return best_val;
+}
+
+/*
+Returns the best move for the minimax player using the minimax algorithm
+*/
+Move get_mini_max_best_move()
+{
+    // set initial difficult of miniMax mod to easy to look only 1 move ahead
+    int difficulty = 0;
+
+    // if difficulty is medium or hard update difficulty
+    if (g_game_difficulty_mode == MEDIUM)
+        difficulty = 1;
+    else if (g_game_difficulty_mode == HARD)
+        difficulty = (ROW * COLUMN) - 1; // look ahead all the way to the end
+
+    // initial best value to a very low value
+    int best_val = -1000;
+
+    // initialize best move row and column value
+    Move best_move = {-1, -1};
+
+    // loop through the board cells
+    for (int i = 0; i < ROW; i++)
+    {
+        for (int j = 0; j < COLUMN; j++)
+        {
+            // if cell is empty, attempt move and see if it is the best move
+            if (g_grid[i][j] == EMPTY)
+            {
+                g_grid[i][j] = g_player_two.tile;
+                int move_val = mini_max(0, 0, difficulty, -1000, 1000);
+                g_grid[i][j] = EMPTY;
+                // if move_val is better than best_val, update best_val and best_move_row and best_move_column
+                if (move_val > best_val)
+                {
+                    best_move.row = i;
+                    best_move.column = j;
+                    best_val = move_val;
+                }
+            }
+        }
+    }
+
+    // return the best move
+    return best_move;
+}
+
+/*
+Takes in a file name and read the dataset into gp_dataset_array
+The array grows as needed so that datasets larger than the UCI file can be read
+Every row must hold a 3x3 board, the program exits on the first row that does not, such as a row of a generated 4x4 dataset
+*/
+void read_ml_dataset(char file_name[])
+{
+    char line[MAX_DATAROW_SIZE];
+    int row_number = 0;
+    int packed_size = 0;
+    const unsigned char *packed_data = find_packed_resource(file_name, &packed_size);
+
+    // read the lines from the resource pack if the dataset is packed
+    if (packed_data != NULL)
+    {
+        read_ml_dataset_lines(file_name, packed_data, packed_size);
+        return;
+    }
+
+#if !defined(_WIN32)
+    // map the file and parse it in place, so the lines are not copied through a stdio buffer
+    int file_descriptor = open(file_name, O_RDONLY);
+    struct stat file_stat;
+    if (file_descriptor >= 0 && fstat(file_descriptor, &file_stat) == 0 && file_stat.st_size > 0 && file_stat.st_size <= INT_MAX)
+    {
+        void *data = mmap(NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+        if (data != MAP_FAILED)
+        {
+            close(file_descriptor);
+            read_ml_dataset_lines(file_name, data, file_stat.st_size);
+            munmap(data, file_stat.st_size);
+            return;
+        }
+    }
+    if (file_descriptor >= 0)
+        close(file_descriptor);
+#endif
+
+    // attempt to open file for reading, used on windows and when the file cannot be mapped
+    FILE *dataset_file = fopen(file_name, "r");
+
+    // error checking for file opening
+    if (!dataset_file)
+    {
+        printf("Error opening file %s\n", file_name);
+        exit(1);
+    }
+
+    // read from data in lines into the struct
+    while (fgets(line, sizeof(line), dataset_file))
+    {
+        row_number++;
+
+        // a line without a newline that is not the last line did not fit in the buffer
+        bool too_long = strchr(line, '\n') == NULL && !feof(dataset_file);
+
+        // remove the newline character from the end of each line, and the carriage return of windows files
+        line[strcspn(line, "\r\n")] = '\0';
+
+        // skip empty lines, such as an empty last line, and stop at the first row that cannot be read
+        if (too_long || (line[0] != '\0' && !parse_ml_data_row(line)))
+        {
+            fclose(dataset_file);
+            report_invalid_ml_data_row(file_name, row_number);
+        }
+    }
+
+    fclose(dataset_file);
+}
+
+/*
+Reads the dataset from size bytes of text that are already in memory, such as the resource pack or a mapped file
+Each line is copied into a buffer so that it is parsed the same way as a line read with fgets
+*/
+void read_ml_dataset_lines(char file_name[], const unsigned char data[], int size)
+{
+    char line[MAX_DATAROW_SIZE];
+    int row_number = 0;
+
+    for (int start = 0, end = 0; start < size; start = end + 1)
+    {
+        for (end = start; end < size && data[end] != '\n'; end++)
+            ;
+
+        row_number++;
+        int length = fmin(end - start, MAX_DATAROW_SIZE - 1);
+        memcpy(line, data + start, length);
+        line[length] = '\0';
+        line[strcspn(line, "\r")] = '\0';
+
+        if (end - start >= MAX_DATAROW_SIZE || (line[0] != '\0' && !parse_ml_data_row(line)))
+            report_invalid_ml_data_row(file_name, row_number);
+    }
+}
+
+/*
+Prints which row of the dataset could not be read and exits, as a model trained on part of a file would be silently wrong
+*/
+void report_invalid_ml_data_row(char file_name[], int row_number)
+{
+    printf("Error reading row %d of dataset %s, each row must be 9 cells of x, o or b followed by positive or negative\n", row_number, file_name);
+    printf("Only datasets of 3x3 boards can be read\n");
+    exit(1);
+}
+
+/*
+Takes in a line of the dataset without the newline character and adds it to gp_dataset_array
+Returns false without adding anything if the line is not a 3x3 board followed by a result
+*/
+bool parse_ml_data_row(char line[])
+{
+    ML_Data_Row data_row;
+
+    // go through each cell in the line and assign respective tile to the struct, each cell is followed by a comma
+    for (int i = 0; i < 9; i++)
+    {
+        if (line[i * 2] == 'x')
+            data_row.tile[i] = CROSS;
+        else if (line[i * 2] == 'o')
+            data_row.tile[i] = CIRCLE;
+        else if (line[i * 2] == 'b')
+            data_row.tile[i] = EMPTY;
+        else
+            return false;
+
+        if (line[i * 2 + 1] != ',')
+            return false;
+    }
+
+    // the last token after the 9 cells is either POSITIVE or NEGATIVE
+    char *token = &line[18];
+
+    // set the current row result to the token value positive or negative
+    if (strcmp(token, "positive") == 0)
+        data_row.result = POSITIVE;
+    else if (strcmp(token, "negative") == 0)
+        data_row.result = NEGATIVE;
+    else
+        return false;
+
+    append_ml_data_row(data_row);
+    return true;
+}
+
+/*
+Adds a row to the end of gp_dataset_array, doubling the capacity of the array when it is full
+*/
+void append_ml_data_row(ML_Data_Row data_row)
+{
+    if (g_dataset_count == g_dataset_capacity)
+    {
+        g_dataset_capacity = g_dataset_capacity == 0 ? DATASET_INITIAL_CAPACITY : g_dataset_capacity * 2;
+        gp_dataset_array = realloc(gp_dataset_array, g_dataset_capacity * sizeof(ML_Data_Row));
+
+        if (!gp_dataset_array)
+        {
+            printf("Error allocating memory for %d rows of dataset\n", g_dataset_capacity);
+            exit(1);
+        }
+    }
+
+    // encode the board once so that duplicate boards can be found by their index
+    data_row.board_index = encode_board(data_row.tile);
+
+    // g_dataset_count is the total number of lines in dataset
+    gp_dataset_array[g_dataset_count++] = data_row;
+}
+
+/*
+Returns the row with its board moved by one of the 8 rotations and reflections of the square
+The result of the game does not change, as every winning line is moved onto another winning line
+*/
+ML_Data_Row transform_ml_data_row(ML_Data_Row data_row, int transform)
+{
+    ML_Data_Row transformed_row = data_row;
+
+    for (int cell = 0; cell < 9; cell++)
+        transformed_row.tile[D4_TRANSFORMS[transform][cell]] = data_row.tile[cell];
+    transformed_row.board_index = encode_board(transformed_row.tile);
+
+    return transformed_row;
+}
+
+/*
+Returns the transform of the row with the lowest board index, so that every symmetric board has the same canonical row
+*/
+ML_Data_Row canonicalize_ml_data_row(ML_Data_Row data_row)
+{
+    ML_Data_Row canonical_row = data_row;
+
+    for (int transform = 1; transform < 8; transform++)
+    {
+        ML_Data_Row transformed_row = transform_ml_data_row(data_row, transform);
+        if (transformed_row.board_index < canonical_row.board_index)
+            canonical_row = transformed_row;
+    }
+
+    return canonical_row;
+}
+
+/*
+Adds the row to the end of the dataset if the same board with the same result has not been added yet
+The row is stored in the set as a bitboard with the result in the top bit of the cross mask
+*/
+void append_unique_ml_data_row(Bitboard_Set *seen, ML_Data_Row data_row)
+{
+    Bitboard board = {(unsigned long long)data_row.result << 63, 0};
+
+    for (int cell = 0; cell < 9; cell++)
+    {
+        if (data_row.tile[cell] == CROSS)
+            board.cross |= 1ULL << cell;
+        else if (data_row.tile[cell] == CIRCLE)
+            board.circle |= 1ULL << cell;
+    }
+
+    if (bitboard_set_insert(seen, board))
+        append_ml_data_row(data_row);
+}
+
+/*
+Replaces the dataset with its rows expanded into all 8 symmetric boards, or folded into their canonical board
+Duplicate rows are removed in every mode, then the number of rows before and after and the throughput are printed
+*/
+void preprocess_ml_dataset(Preprocess_Mode mode)
+{
+    ML_Data_Row *source_rows = gp_dataset_array;
+    int source_count = g_dataset_count;
+    Bitboard_Set seen;
+
+    // the rows are appended into a new array, the old one is freed at the end
+    gp_dataset_array = NULL;
+    g_dataset_count = 0;
+    g_dataset_capacity = 0;
+
+    double start_time = get_monotonic_time();
+
+    bitboard_set_init(&seen, mode == PREPROCESS_AUGMENT ? source_count * 8 : source_count);
+    for (int i = 0; i < source_count; i++)
+    {
+        if (mode == PREPROCESS_AUGMENT)
+            for (int transform = 0; transform < 8; transform++)
+                append_unique_ml_data_row(&seen, transform_ml_data_row(source_rows[i], transform));
+        else if (mode == PREPROCESS_CANONICAL)
+            append_unique_ml_data_row(&seen, canonicalize_ml_data_row(source_rows[i]));
+        else
+            append_unique_ml_data_row(&seen, source_rows[i]);
+    }
+
+    double elapsed_time = get_monotonic_time() - start_time;
+    int candidate_count = mode == PREPROCESS_AUGMENT ? source_count * 8 : source_count;
+
+    printf("%d rows in, %d candidate rows, %d unique rows out, %.3f rows out per row in\n",
+           source_count, candidate_count, g_dataset_count, source_count > 0 ? (double)g_dataset_count / source_count : 0);
+    printf("%d duplicates removed (%.1f%% of candidates), %.0f rows per second\n", candidate_count - g_dataset_count,
+           candidate_count > 0 ? 100.0 * (candidate_count - g_dataset_count) / candidate_count : 0, elapsed_time > 0 ? source_count / elapsed_time : 0);
+
+    bitboard_set_free(&seen);
+    free(source_rows);
+}
+
+/*
+Writes the dataset into a file in the same format as the UCI dataset, so that it can be read by read_ml_dataset()
+*/
+void write_ml_dataset(char file_name[])
+{
+    FILE *dataset_file = fopen(file_name, "w");
+
+    if (!dataset_file)
+    {
+        printf("Error opening file %s\n", file_name);
+        exit(1);
+    }
+
+    const char TILE_CHARACTERS[3] = {'b', 'x', 'o'};
+    for (int i = 0; i < g_dataset_count; i++)
+    {
+        for (int cell = 0; cell < 9; cell++)
+            fprintf(dataset_file, "%c,", TILE_CHARACTERS[gp_dataset_array[i].tile[cell]]);
+        fputs(gp_dataset_array[i].result == POSITIVE ? "positive\n" : "negative\n", dataset_file);
+    }
+
+    fclose(dataset_file);
+}
+
+/*
+shuffle the dataset array with the given random generator, in parallel for large datasets, then stratify it
+The same seed always produces the same order, so that results can be reproduced
+*/
+void shuffle_dataset(Random *random)
+{
+    parallel_shuffle(gp_dataset_array, sizeof(ML_Data_Row), g_dataset_count, random);
+    stratify_dataset();
+}
+
+/*
+Spreads the positive and negative rows of the shuffled dataset evenly, so that every prefix has the share of positive rows of the whole dataset
+Every training split of the models is then stratified, which a shuffle alone only gives on average
+The rows of each result keep their shuffled order
+*/
+void stratify_dataset()
+{
+    ML_Data_Row *rows = malloc(sizeof(ML_Data_Row) * (g_dataset_count + 1));
+    if (!rows)
+    {
+        printf("Error allocating memory for %d rows of dataset\n", g_dataset_count);
+        exit(1);
+    }
+
+    // move the positive rows to the front of the copy and the negative rows after them
+    int positive_count = 0;
+    for (int i = 0; i < g_dataset_count; i++)
+        positive_count += gp_dataset_array[i].result == POSITIVE;
+
+    int positive_index = 0, negative_index = positive_count;
+    for (int i = 0; i < g_dataset_count; i++)
+        if (gp_dataset_array[i].result == POSITIVE)
+            rows[positive_index++] = gp_dataset_array[i];
+        else
+            rows[negative_index++] = gp_dataset_array[i];
+
+    // take a positive row whenever the first i + 1 rows have fewer positive rows than their rounded share
+    positive_index = 0;
+    negative_index = positive_count;
+    for (int i = 0; i < g_dataset_count; i++)
+    {
+        long long positive_share = ((long long)(i + 1) * positive_count + g_dataset_count / 2) / g_dataset_count;
+        if (positive_index < positive_share)
+            gp_dataset_array[i] = rows[positive_index++];
+        else
+            gp_dataset_array[i] = rows[negative_index++];
+    }
+
+    free(rows);
+}
+
+/*
+Shuffles and stratifies the dataset the first time a ML gamemode is started
+Every model then splits the same training and test data, no matter which gamemode is started first
+*/
+void prepare_ml_dataset()
+{
+    if (!g_dataset_shuffled)
+    {
+        // seed with the time the game was launched so that the shuffle is different each time, the seed is saved in every replay
+        Random random;
+        random_seed(&random, g_session_seed);
+        shuffle_dataset(&random);
+        g_dataset_shuffled = true;
+    }
+}
+
+/*
+Train the naive bayes probability algorithm and make it the model used for prediction
+*/
+void naive_bayes_learn(float training_data_weight)
+{
+    // only use a portion of the total dataset for learning
+    int training_data_count = ceil(g_dataset_count * training_data_weight);
+    Naive_Bayes_Model *model = begin_naive_bayes_update();
+
+    // reset the model, count the training data and calculate the probabilities
+    naive_bayes_reset(model);
+    naive_bayes_count(model, gp_dataset_array, NULL, training_data_count);
+    naive_bayes_finalize(model);
+    // compile the trained model into the lookup table used for batch prediction
+    naive_bayes_build_table(model);
+    publish_naive_bayes_update(model);
+}
+
+/*
+Adds a single labeled row to the counts of the model used for prediction without retraining
+Only the counts of the row's result change, so only the probabilities of that result and the priors are recalculated
+The prediction table is rebuilt lazily by prepare_naive_bayes_table the next time a batch is evaluated, moves are scored without it
+*/
+void naive_bayes_learn_row(ML_Data_Row data_row)
+{
+    Naive_Bayes_Model *model = begin_naive_bayes_update();
+
+    naive_bayes_count(model, &data_row, NULL, 1);
+    naive_bayes_finalize_result(model, data_row.result);
+    publish_naive_bayes_update(model);
+}
+
+/*
+Adds the final board of the game that just ended to the learned games, and into the model if it has been trained
+The row is labeled the same way as the dataset, positive if cross has won
+The learned games are not added to the dataset, so the training and test data of every model stay the same for the session
+*/
+void learn_finished_game()
+{
+    ML_Data_Row data_row;
+
+    for (int i = 0; i < ROW; i++)
+        for (int j = 0; j < COLUMN; j++)
+            data_row.tile[i * 3 + j] = g_grid[i][j];
+    data_row.result = gp_winner != NULL && gp_winner->tile == CROSS ? POSITIVE : NEGATIVE;
+    data_row.board_index = encode_board(data_row.tile);
+
+    if (g_learned_game_count == g_learned_game_capacity)
+    {
+        g_learned_game_capacity = g_learned_game_capacity == 0 ? LEARNED_GAMES_INITIAL_CAPACITY : g_learned_game_capacity * 2;
+        gp_learned_games = realloc(gp_learned_games, g_learned_game_capacity * sizeof(ML_Data_Row));
+
+        if (!gp_learned_games)
+        {
+            printf("Error allocating memory for %d learned games\n", g_learned_game_capacity);
+            exit(1);
+        }
+    }
+    gp_learned_games[g_learned_game_count++] = data_row;
+
+    apply_learned_games();
+}
+
+/*
+Adds the learned games that are not in the naive bayes model yet to it
+Never waits for the startup loader, while it is still training the model the games are kept until the next call
+*/
+void apply_learned_games()
+{
+    if (!is_startup_loader_finished() || !g_naive_bayes_trained)
+        return;
+
+    for (; g_applied_game_count < g_learned_game_count; g_applied_game_count++)
+        naive_bayes_learn_row(gp_learned_games[g_applied_game_count]);
+}
+
+/*
+Returns the naive bayes model to use for prediction, release_naive_bayes_model must be called once done with it
+Readers never wait, the model is not changed until it is released
+*/
+const Naive_Bayes_Model *acquire_naive_bayes_model()
+{
+    while (true)
+    {
+        Naive_Bayes_Model *model = __atomic_load_n(&gp_naive_bayes_model, __ATOMIC_SEQ_CST);
+        int buffer = model - g_naive_bayes_models;
+
+        // register as a reader, then check that the model was not swapped before the reader was registered
+        __atomic_fetch_add(&g_naive_bayes_readers[buffer], 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&gp_naive_bayes_model, __ATOMIC_SEQ_CST) == model)
+            return model;
+
+        // the model was swapped, try again with the new model
+        __atomic_fetch_sub(&g_naive_bayes_readers[buffer], 1, __ATOMIC_SEQ_CST);
+    }
+}
+
+/*
+Releases a model that was returned by acquire_naive_bayes_model
+*/
+void release_naive_bayes_model(const Naive_Bayes_Model *model)
+{
+    __atomic_fetch_sub(&g_naive_bayes_readers[model - g_naive_bayes_models], 1, __ATOMIC_SEQ_CST);
+}
+
+/*
+Returns the model that is not used for prediction, with the current model copied into it
+Waits until no reader is still using it, publish_naive_bayes_update must be called once the update is done
+*/
+Naive_Bayes_Model *begin_naive_bayes_update()
+{
+    pthread_mutex_lock(&g_naive_bayes_update_lock);
+
+    Naive_Bayes_Model *current_model = gp_naive_bayes_model;
+    Naive_Bayes_Model *model = current_model == &g_naive_bayes_models[0] ? &g_naive_bayes_models[1] : &g_naive_bayes_models[0];
+
+    // wait for readers that acquired this model before the last swap, they only hold it for a single prediction
+    while (__atomic_load_n(&g_naive_bayes_readers[model - g_naive_bayes_models], __ATOMIC_SEQ_CST) > 0)
+        ;
+
+    // start from the current model so that an update only has to recalculate what it changes, the table is rebuilt instead of copied
+    memcpy(model, current_model, offsetof(Naive_Bayes_Model, table));
+    model->table_built = false;
+
+    return model;
+}
+
+/*
+Makes the updated model the one used for prediction, new readers will get it from now on
+*/
+void publish_naive_bayes_update(Naive_Bayes_Model *model)
+{
+    __atomic_store_n(&gp_naive_bayes_model, model, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&g_naive_bayes_update_lock);
+}
+
+/*
+Clears all the counts and probabilities of a model before training
+*/
+void naive_bayes_reset(Naive_Bayes_Model *model)
+{
+    memset(model->tile_count, 0, sizeof(model->tile_count));
+    memset(model->result_count, 0, sizeof(model->result_count));
+    model->smoothing = NB_SMOOTHING;
+    model->table_built = false;
+}
+
+/*
+Adds the count of each tile and result of the data rows into the model
+If order is not NULL, the rows data_rows[order[0]] to data_rows[order[count - 1]] are counted instead of the first count rows
+Can be called multiple times to train on data that is not contiguous, naive_bayes_finalize must be called after
+*/
+void naive_bayes_count(Naive_Bayes_Model *model, const ML_Data_Row data_rows[], const int order[], int count)
+{
+    // loop through the training data and count the occurence of each tile
+    for (int i = 0; i < count; i++)
+    {
+        // get the current training data
+        const ML_Data_Row *current_row = &data_rows[order != NULL ? order[i] : i];
+
+        // increment the positive or negative counter
+        model->result_count[current_row->result]++;
+
+        /*
+        increment the count of each tile in tile_count, where
+        for each row, first 3 columns are positive {Xp, Op, Bp}, last 3 columns are negative {Xn, On, Bn}
+        row_offset will offset the array index depending whether the current result is positive or negative
+        */
+        int row_offset = current_row->result == POSITIVE ? 0 : 3;
+
+        for (int row = 0; row < 9; row++)
+        {
+            switch (current_row->tile[row])
+            {
+            case CROSS:
+                model->tile_count[row][0 + row_offset]++;
+                break;
+            case CIRCLE:
+                model->tile_count[row][1 + row_offset]++;
+                break;
+            case EMPTY:
+                model->tile_count[row][2 + row_offset]++;
+                break;
+            }
+        }
+    }
+}
+
+/*
+Calculates the probabilities of the model from its counts, and converts them into log space for prediction
+*/
+void naive_bayes_finalize(Naive_Bayes_Model *model)
+{
+    naive_bayes_finalize_result(model, POSITIVE);
+    naive_bayes_finalize_result(model, NEGATIVE);
+}
+
+/*
+Calculates the probabilities and the log table of one result from the counts, and the prior of both results
+The probabilities of a result only depend on the rows of that result, so adding one row only needs its result to be recalculated
+*/
+void naive_bayes_finalize_result(Naive_Bayes_Model *model, Data_Result result)
+{
+    double total_count = model->result_count[POSITIVE] + model->result_count[NEGATIVE];
+    // first 3 columns are positive {Xp, Op, Bp}, last 3 columns are negative {Xn, On, Bn}
+    int col_offset = result == POSITIVE ? 0 : 3;
+
+    /*
+    calculate the probability of each tile by taking the total
+    occurence of state of the cell / total occurence of positive or negative
+    with smoothing, every one of the 3 tiles is counted smoothing more times so that no probability is 0
+    */
+    double result_count = model->result_count[result] + 3 * model->smoothing;
+    model->table_built = false;
+    for (int row = 0; row < 9; row++)
+        for (int col = col_offset; col < col_offset + 3; col++)
+            model->probability[row][col] = result_count > 0 ? (model->tile_count[row][col] + model->smoothing) / result_count : 0;
+
+    // prior probability of positive p(P) and negative p(N)
+    model->prior[POSITIVE] = total_count > 0 ? model->result_count[POSITIVE] / total_count : 0;
+    model->prior[NEGATIVE] = total_count > 0 ? model->result_count[NEGATIVE] / total_count : 0;
+
+    // convert the probabilities into log space, indexed by [result][cell][tile] for prediction
+    model->log_prior[POSITIVE] = log(model->prior[POSITIVE]);
+    model->log_prior[NEGATIVE] = log(model->prior[NEGATIVE]);
+    for (int row = 0; row < 9; row++)
+    {
+        model->log_table[result][row][CROSS] = log(model->probability[row][col_offset + 0]);
+        model->log_table[result][row][CIRCLE] = log(model->probability[row][col_offset + 1]);
+        model->log_table[result][row][EMPTY] = log(model->probability[row][col_offset + 2]);
+    }
+}
+
+/*
+converts the current grid into a ML_Data_Row struct
+*/
+ML_Data_Row get_current_grid()
+{
+    // initialize the current row as a ML_Data_Row struct, the board index is only set for the rows of the dataset
+    ML_Data_Row current_row = {0};
+
+    // loop through the grid and convert the 2d array into a 1d array
+    for (int i = 0; i < ROW; i++)
+    {
+        for (int j = 0; j < COLUMN; j++)
+        {
+            /*
+            As the ML data set is trained to predict X to win, this function must be modular
+            to account for the AI player to be either X or O
+            */
+            if (g_player_two.tile == CIRCLE)
+            {
+                if (g_grid[i][j] == CIRCLE)
+                    current_row.tile[i * 3 + j] = CROSS;
+                else if (g_grid[i][j] == CROSS)
+                    current_row.tile[i * 3 + j] = CIRCLE;
+                else
+                    current_row.tile[i * 3 + j] = g_grid[i][j];
+            }
+            else
+                current_row.tile[i * 3 + j] = g_grid[i][j];
+        }
+    }
+
+    current_row.result = NEGATIVE;
+
+    return current_row;
+}
+
+/*
+Encodes the tiles of a board into a base 3 number, each cell is a digit (EMPTY = 0, CROSS = 1, CIRCLE = 2)
+The result is a unique index between 0 and BOARD_STATE_COUNT - 1
+*/
+int encode_board(const Tile tile[9])
+{
+    int board_index = 0;
+
+    for (int i = 0; i < 9; i++)
+        board_index += tile[i] * CELL_WEIGHT[i];
+
+    return board_index;
+}
+
+/*
+Scores placing a cross on every empty cell of the row in a single pass, without copying the board for each candidate
+The log score of each result is summed once for the current board, then each candidate only swaps the factor of its own cell
+Factors of a zero probability are counted instead of summed, as -infinity minus -infinity would be NaN
+The prediction of each empty cell is written into predicted_results at the index of the cell, the same as naive_bayes_predict_batch()
+*/
+void naive_bayes_score_moves(const Naive_Bayes_Model *model, const ML_Data_Row *data_row, Predicted_Result predicted_results[9])
+{
+    double finite_sum[2];
+    int zero_count[2];
+
+    // sum the log score of the current board for each result
+    for (int result = NEGATIVE; result <= POSITIVE; result++)
+    {
+        finite_sum[result] = isinf(model->log_prior[result]) ? 0 : model->log_prior[result];
+        zero_count[result] = isinf(model->log_prior[result]);
+
+        for (int cell = 0; cell < 9; cell++)
+        {
+            double factor = model->log_table[result][cell][data_row->tile[cell]];
+            finite_sum[result] += isinf(factor) ? 0 : factor;
+            zero_count[result] += isinf(factor);
+        }
+    }
+
+    for (int cell = 0; cell < 9; cell++)
+    {
+        if (data_row->tile[cell] != EMPTY)
+            continue;
+
+        double score[2];
+        for (int result = NEGATIVE; result <= POSITIVE; result++)
+        {
+            // swap the factor of an empty cell for the factor of a cross on the cell
+            double empty_factor = model->log_table[result][cell][EMPTY];
+            double cross_factor = model->log_table[result][cell][CROSS];
+            double sum = finite_sum[result] - (isinf(empty_factor) ? 0 : empty_factor) + (isinf(cross_factor) ? 0 : cross_factor);
+            int zeros = zero_count[result] - isinf(empty_factor) + isinf(cross_factor);
+
+            score[result] = zeros > 0 ? -INFINITY : sum;
+        }
+
+        // ties go to positive, the same as naive_bayes_predict_batch()
+        predicted_results[cell].result = score[POSITIVE] >= score[NEGATIVE] ? POSITIVE : NEGATIVE;
+        predicted_results[cell].score = fmax(score[POSITIVE], score[NEGATIVE]);
+    }
+}
+
+/*
+Takes in a ML_Data_Row struct and returns the predicted result of the function parameter data using the current model
+The score is the log probability of the predicted result
+*/
+Predicted_Result naive_bayes_predict(ML_Data_Row data)
+{
+    Predicted_Result predicted_result;
+    const Naive_Bayes_Model *model = acquire_naive_bayes_model();
+
+    naive_bayes_predict_rows(model, &data, 1, &predicted_result);
+    release_naive_bayes_model(model);
+
+    return predicted_result;
+}
+
+/*
+Predicts every possible board with the model and stores the results in its table, so that a prediction becomes a single lookup
+Called after training, the boards are enumerated in the order of encode_board() and predicted in batches
+*/
+void naive_bayes_build_table(Naive_Bayes_Model *model)
+{
+    ML_Data_Row data_rows[PREDICT_BATCH_SIZE];
+    Tile tile[9] = {EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY};
+
+    for (int batch_start = 0; batch_start < BOARD_STATE_COUNT; batch_start += PREDICT_BATCH_SIZE)
+    {
+        int batch_count = fmin(PREDICT_BATCH_SIZE, BOARD_STATE_COUNT - batch_start);
+        for (int i = 0; i < batch_count; i++)
+        {
+            memcpy(data_rows[i].tile, tile, sizeof(tile));
+            data_rows[i].board_index = batch_start + i;
+
+            // increment the board by one in base 3, carrying over to the next cell when a digit overflows
+            for (int cell = 0; cell < 9; cell++)
+            {
+                if (tile[cell] != CIRCLE)
+                {
+                    tile[cell]++;
+                    break;
+                }
+                tile[cell] = EMPTY;
+            }
+        }
+        naive_bayes_predict_batch(model, data_rows, batch_count, &model->table[batch_start]);
+    }
+
+    model->table_built = true;
+}
+
+/*
+Rebuilds the prediction table of the model used for prediction if games were learned since it was built
+The table is built into the other buffer and published, so readers of the current model are not disturbed
+*/
+void prepare_naive_bayes_table()
+{
+    const Naive_Bayes_Model *current_model = acquire_naive_bayes_model();
+    bool table_built = current_model->table_built;
+    release_naive_bayes_model(current_model);
+    if (table_built)
+        return;
+
+    Naive_Bayes_Model *model = begin_naive_bayes_update();
+    naive_bayes_build_table(model);
+    publish_naive_bayes_update(model);
+}
+
+/*
+Predicts count rows into predicted_results, with one lookup per row if the table of the model is built
+Otherwise the rows are scored with naive_bayes_predict_batch, which gives the same results
+*/
+void naive_bayes_predict_rows(const void *model_data, const ML_Data_Row data_rows[], int count, Predicted_Result predicted_results[])
+{
+    const Naive_Bayes_Model *model = model_data;
+
+    if (!model->table_built)
+    {
+        naive_bayes_predict_batch(model, data_rows, count, predicted_results);
+        return;
+    }
+
+    for (int i = 0; i < count; i++)
+        predicted_results[i] = model->table[data_rows[i].board_index];
+}
+
+/*
+Writes the log prior plus the log probability of every tile of the row for each result, which naive bayes compares to predict the row
+*/
+void naive_bayes_row_scores(const Naive_Bayes_Model *model, const ML_Data_Row *data_row, double scores[2])
+{
+    // initialize log prior probablity log p(P) and log p(N)
+    scores[POSITIVE] = model->log_prior[POSITIVE];
+    scores[NEGATIVE] = model->log_prior[NEGATIVE];
+
+    // loop through each tile and add the log probability of the tile into the score
+    for (int cell = 0; cell < 9; cell++)
+    {
+        Tile tile = data_row->tile[cell];
+        scores[POSITIVE] += model->log_table[POSITIVE][cell][tile];
+        scores[NEGATIVE] += model->log_table[NEGATIVE][cell][tile];
+    }
+}
+
+/*
+Scores count rows at once and writes each prediction into predicted_results
+Probabilities are summed in log space so that boards with many cells do not underflow to 0
+Uses AVX2 gathers to score 4 rows per iteration when compiled with -mavx2, remaining rows are scored one at a time
+*/
+void naive_bayes_predict_batch(const Naive_Bayes_Model *model, const ML_Data_Row data_rows[], int count, Predicted_Result predicted_results[])
+{
+    int i = 0;
+
+#if defined(__AVX2__)
+    // offsets in ints between the same tile of 4 consecutive rows, used to gather one cell from 4 rows at once
+    const __m128i row_offsets = _mm_setr_epi32(0, 1, 2, 3);
+    const __m128i row_stride = _mm_set1_epi32(sizeof(ML_Data_Row) / sizeof(int));
+    const __m128i gather_offsets = _mm_mullo_epi32(row_offsets, row_stride);
+
+    for (; i + 4 <= count; i += 4)
+    {
+        // initialize log prior probability log p(P) and log p(N) for each of the 4 rows
+        __m256d positive_score = _mm256_set1_pd(model->log_prior[POSITIVE]);
+        __m256d negative_score = _mm256_set1_pd(model->log_prior[NEGATIVE]);
+
+        for (int cell = 0; cell < 9; cell++)
+        {
+            // gather the tile of this cell from the 4 rows, and turn it into an index of the log table
+            __m128i tiles = _mm_i32gather_epi32((const int *)&data_rows[i].tile[cell], gather_offsets, 4);
+            __m128i table_index = _mm_add_epi32(tiles, _mm_set1_epi32(cell * 3));
+
+            // gather the log probability of each tile and add it into the score
+            positive_score = _mm256_add_pd(positive_score, _mm256_i32gather_pd(&model->log_table[POSITIVE][0][0], table_index, 8));
+            negative_score = _mm256_add_pd(negative_score, _mm256_i32gather_pd(&model->log_table[NEGATIVE][0][0], table_index, 8));
+        }
+
+        double positive_lanes[4], negative_lanes[4];
+        _mm256_storeu_pd(positive_lanes, positive_score);
+        _mm256_storeu_pd(negative_lanes, negative_score);
+
+        // compare whether the positive or negative is higher, ties go to positive
+        for (int lane = 0; lane < 4; lane++)
+        {
+            bool is_positive = positive_lanes[lane] >= negative_lanes[lane];
+            predicted_results[i + lane].result = is_positive ? POSITIVE : NEGATIVE;
+            predicted_results[i + lane].score = is_positive ? positive_lanes[lane] : negative_lanes[lane];
+        }
+    }
+#endif
+
+    // scalar loop for the rows that are left over, or for every row when AVX2 is not available
+    for (; i < count; i++)
+    {
+        double scores[2];
+        naive_bayes_row_scores(model, &data_rows[i], scores);
+
+        // compare whether the positive or negative is higher, the higher of those will be the predicted probability
+        if (scores[POSITIVE] >= scores[NEGATIVE])
+        {
+            predicted_results[i].result = POSITIVE;
+            predicted_results[i].score = scores[POSITIVE];
+        }
+        else
+        {
+            predicted_results[i].result = NEGATIVE;
+            predicted_results[i].score = scores[NEGATIVE];
+        }
+    }
+}
+
+/*
+Converts the log probabilities of a trained model to int16 fixed point, with NB_QUANTIZATION_SCALE steps per nat
+Finite values are limited to NB_QUANTIZED_LOG_LIMIT, and the log of a probability of 0 becomes SHRT_MIN
+*/
+void naive_bayes_quantize(const Naive_Bayes_Model *model, Quantized_Naive_Bayes_Model *quantized_model)
+{
+    for (int result = 0; result < 2; result++)
+    {
+        const double *log_values = &model->log_table[result][0][0];
+        short *quantized_values = &quantized_model->log_table[result][0][0];
+        for (int i = 0; i < 9 * 3; i++)
+            quantized_values[i] = isinf(log_values[i]) ? SHRT_MIN : (short)lrint(fmax(-NB_QUANTIZED_LOG_LIMIT, log_values[i] * NB_QUANTIZATION_SCALE));
+
+        quantized_model->log_prior[result] = isinf(model->log_prior[result]) ? SHRT_MIN : (short)lrint(fmax(-NB_QUANTIZED_LOG_LIMIT, model->log_prior[result] * NB_QUANTIZATION_SCALE));
+    }
+}
+
+/*
+Predicts count rows with the quantized model, same results as naive_bayes_predict_batch() apart from the rounding of the log probabilities
+The scores are summed in ints, with AVX2 summing 8 rows per instruction when compiled with -mavx2
+*/
+void quantized_naive_bayes_predict_batch(const void *model_data, const ML_Data_Row data_rows[], int count, Predicted_Result predicted_results[])
+{
+    const Quantized_Naive_Bayes_Model *model = model_data;
+    int i = 0;
+
+#if defined(__AVX2__)
+    // offsets in ints between the same tile of 8 consecutive rows, used to gather one cell from 8 rows at once
+    const __m256i row_offsets = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i gather_offsets = _mm256_mullo_epi32(row_offsets, _mm256_set1_epi32(sizeof(ML_Data_Row) / sizeof(int)));
+
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i positive_score = _mm256_set1_epi32(model->log_prior[POSITIVE]);
+        __m256i negative_score = _mm256_set1_epi32(model->log_prior[NEGATIVE]);
+
+        for (int cell = 0; cell < 9; cell++)
+        {
+            __m256i tiles = _mm256_i32gather_epi32((const int *)&data_rows[i].tile[cell], gather_offsets, 4);
+            __m256i table_index = _mm256_add_epi32(tiles, _mm256_set1_epi32(cell * 3));
+
+            // there is no 16 bit gather, so 32 bits are gathered at each short and its low half is sign extended
+            __m256i positive_log = _mm256_i32gather_epi32((const int *)&model->log_table[POSITIVE][0][0], table_index, 2);
+            __m256i negative_log = _mm256_i32gather_epi32((const int *)&model->log_table[NEGATIVE][0][0], table_index, 2);
+            positive_score = _mm256_add_epi32(positive_score, _mm256_srai_epi32(_mm256_slli_epi32(positive_log, 16), 16));
+            negative_score = _mm256_add_epi32(negative_score, _mm256_srai_epi32(_mm256_slli_epi32(negative_log, 16), 16));
+        }
+
+        int positive_lanes[8], negative_lanes[8];
+        _mm256_storeu_si256((__m256i *)positive_lanes, positive_score);
+        _mm256_storeu_si256((__m256i *)negative_lanes, negative_score);
+
+        // compare whether the positive or negative is higher, ties go to positive
+        for (int lane = 0; lane < 8; lane++)
+        {
+            bool is_positive = positive_lanes[lane] >= negative_lanes[lane];
+            predicted_results[i + lane].result = is_positive ? POSITIVE : NEGATIVE;
+            predicted_results[i + lane].score = (is_positive ? positive_lanes[lane] : negative_lanes[lane]) / NB_QUANTIZATION_SCALE;
+        }
+    }
+#endif
+
+    // scalar loop for the rows that are left over, or for every row when AVX2 is not available
+    for (; i < count; i++)
+    {
+        int positive_score = model->log_prior[POSITIVE];
+        int negative_score = model->log_prior[NEGATIVE];
+        for (int cell = 0; cell < 9; cell++)
+        {
+            positive_score += model->log_table[POSITIVE][cell][data_rows[i].tile[cell]];
+            negative_score += model->log_table[NEGATIVE][cell][data_rows[i].tile[cell]];
+        }
+
+        bool is_positive = positive_score >= negative_score;
+        predicted_results[i].result = is_positive ? POSITIVE : NEGATIVE;
+        predicted_results[i].score = (is_positive ? positive_score : negative_score) / NB_QUANTIZATION_SCALE;
+    }
+}
+
+/*
+Returns the best move based on the naive bayes prediction
+*/
+Move get_naive_bayes_best_move()
+{
+    // initialize best score to the lowest log probability
+    double best_score = -INFINITY;
+    bool positive_move_found = false;
+    Move best_move = {-1, -1};
+
+    // score every empty cell in one pass, get_current_grid() always maps the AI tile to CROSS
+    ML_Data_Row current_row = get_current_grid();
+    Predicted_Result predicted_results[9];
+    const Naive_Bayes_Model *model = acquire_naive_bayes_model();
+    naive_bayes_score_moves(model, &current_row, predicted_results);
+    release_naive_bayes_model(model);
+
+    // loop through the grid, if cell is empty, place tile and calculate the score
+    for (int i = 0; i < ROW; i++)
+    {
+        for (int j = 0; j < COLUMN; j++)
+        {
+            // if cell is empty, attempt move and see if it is the best move
+            if (g_grid[i][j] == EMPTY)
+            {
+                Predicted_Result predicted_result = predicted_results[i * 3 + j];
+
+                // Get the best move by comparing the score of each move, with positive prediction move having higher priority
+                if (predicted_result.result == POSITIVE || (predicted_result.result == NEGATIVE && !positive_move_found))
+                {
+                    if (predicted_result.result == POSITIVE)
+                        // if positive move is found, set positive_move_found to true, so that we will only take positive move
+                        positive_move_found = true;
+
+                    // the first candidate is always taken, as a log probability of 0 is -infinity
+                    if (predicted_result.score > best_score || best_move.row == -1)
+                    {
+                        // if the score is better than the current best score, update the best score and best move
+                        best_score = predicted_result.score;
+                        best_move.row = i;
+                        best_move.column = j;
+                    }
+                }
+            }
+        }
+    }
+
+    return best_move;
+}
+
+/*
+Packs the tiles of a board into a single int, bit i is set if cell i is a cross and bit i + 16 if it is a circle
+The hamming distance between two packed boards is 1 for a tile against an empty cell and 2 for a cross against a circle
+*/
+unsigned int pack_board(const Tile tile[9])
+{
+    unsigned int packed_board = 0;
+
+    for (int i = 0; i < 9; i++)
+    {
+        if (tile[i] == CROSS)
+            packed_board |= 1u << i;
+        else if (tile[i] == CIRCLE)
+            packed_board |= 1u << (i + 16);
+    }
+
+    return packed_board;
+}
+
+/*
+Builds the nearest neighbour model from the training rows
+Rows with the same board are merged into one entry with a count of each result, so the scan only visits distinct boards
+*/
+void knn_train(Knn_Model *model, const ML_Data_Row data_rows[], int count)
+{
+    // count the results of every possible board, indexed by the board index of the rows
+    // allocated for every call so that models can be trained on several threads at once
+    int *positive_count = calloc(BOARD_STATE_COUNT, sizeof(int));
+    int *negative_count = calloc(BOARD_STATE_COUNT, sizeof(int));
+    if (!positive_count || !negative_count)
+    {
+        printf("Error allocating memory for the nearest neighbour counts\n");
+        exit(1);
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        if (data_rows[i].result == POSITIVE)
+            positive_count[data_rows[i].board_index]++;
+        else
+            negative_count[data_rows[i].board_index]++;
+    }
+
+    // store the boards that appear in the training data in packed form
+    model->count = 0;
+    for (int board_index = 0; board_index < BOARD_STATE_COUNT; board_index++)
+    {
+        if (positive_count[board_index] == 0 && negative_count[board_index] == 0)
+            continue;
+
+        Tile tile[9];
+        for (int i = 0, digits = board_index; i < 9; i++, digits /= 3)
+            tile[i] = digits % 3;
+
+        model->packed_boards[model->count] = pack_board(tile);
+        model->positive_count[model->count] = positive_count[board_index];
+        model->negative_count[model->count] = negative_count[board_index];
+        model->count++;
+    }
+
+    free(positive_count);
+    free(negative_count);
+}
+
+/*
+Predicts the result of every packed candidate board from the K_NEAREST closest training boards
+The training boards are scanned one block at a time and each block is compared against every candidate while it is in the cache
+Instead of sorting neighbours, the votes are counted per distance and the closest distances are taken until K_NEAREST votes are reached
+*/
+void knn_predict_batch(const Knn_Model *model, const unsigned int candidates[], int candidate_count, Predicted_Result predicted_results[])
+{
+    // votes of each result for every candidate at every possible distance
+    int positive_votes[KNN_MAX_CANDIDATES][KNN_MAX_DISTANCE + 1];
+    int negative_votes[KNN_MAX_CANDIDATES][KNN_MAX_DISTANCE + 1];
+    memset(positive_votes, 0, sizeof(positive_votes));
+    memset(negative_votes, 0, sizeof(negative_votes));
+
+    for (int block_start = 0; block_start < model->count; block_start += KNN_BLOCK_SIZE)
+    {
+        int block_end = fmin(block_start + KNN_BLOCK_SIZE, model->count);
+
+        for (int candidate = 0; candidate < candidate_count; candidate++)
+        {
+            for (int i = block_start; i < block_end; i++)
+            {
+                // the distance is the number of bits that differ between the two packed boards
+                int distance = __builtin_popcount(candidates[candidate] ^ model->packed_boards[i]);
+                positive_votes[candidate][distance] += model->positive_count[i];
+                negative_votes[candidate][distance] += model->negative_count[i];
+            }
+        }
+    }
+
+    for (int candidate = 0; candidate < candidate_count; candidate++)
+    {
+        double positive_score = 0, negative_score = 0;
+        int vote_count = 0;
+
+        // take the closest distances first, all the boards at the last distance are kept so ties do not depend on order
+        for (int distance = 0; distance <= KNN_MAX_DISTANCE && vote_count < K_NEAREST; distance++)
+        {
+            // closer neighbours have a higher weight
+            double weight = 1.0 / (1 + distance);
+            positive_score += positive_votes[candidate][distance] * weight;
+            negative_score += negative_votes[candidate][distance] * weight;
+            vote_count += positive_votes[candidate][distance] + negative_votes[candidate][distance];
+        }
+
+        // the score is between -1 and 1, positive when most of the weighted neighbours are positive
+        double total_score = positive_score + negative_score;
+        predicted_results[candidate].score = total_score > 0 ? (positive_score - negative_score) / total_score : 0;
+        predicted_results[candidate].result = predicted_results[candidate].score >= 0 ? POSITIVE : NEGATIVE;
+    }
+}
+
+/*
+Returns the best move based on the nearest neighbour prediction, every empty cell is scored in one batch
+*/
+Move get_knn_best_move()
+{
+    unsigned int candidates[KNN_MAX_CANDIDATES];
+    Move candidate_moves[KNN_MAX_CANDIDATES];
+    Predicted_Result predicted_results[KNN_MAX_CANDIDATES];
+    int candidate_count = 0;
+
+    // get_current_grid() maps the AI tile to CROSS, so each candidate adds a cross to the packed board
+    unsigned int packed_board = pack_board(get_current_grid().tile);
+
+    for (int i = 0; i < ROW; i++)
+        for (int j = 0; j < COLUMN; j++)
+            if (g_grid[i][j] == EMPTY)
+            {
+                candidates[candidate_count] = packed_board | 1u << (i * 3 + j);
+                candidate_moves[candidate_count] = (Move){i, j};
+                candidate_count++;
+            }
+
+    knn_predict_batch(&g_knn_model, candidates, candidate_count, predicted_results);
+
+    // the candidate with the highest score is the best move
+    int best_candidate = 0;
+    for (int i = 1; i < candidate_count; i++)
+        if (predicted_results[i].score > predicted_results[best_candidate].score)
+            best_candidate = i;
+
+    return candidate_count > 0 ? candidate_moves[best_candidate] : (Move){-1, -1};
+}
+
+/*
+Sets the weights of the network to small random values and the biases to 0
+*/
+void mlp_init(Mlp_Model *model, unsigned long long seed)
+{
+    Random random;
+    random_seed(&random, seed);
+    // scale of the uniform random weights, so that the hidden units start with a similar variance
+    float hidden_scale = sqrtf(6.0f / (MLP_INPUT_SIZE + MLP_HIDDEN_SIZE));
+    float output_scale = sqrtf(6.0f / (MLP_HIDDEN_SIZE + 1));
+
+    memset(model, 0, sizeof(Mlp_Model));
+    for (int input = 0; input < MLP_INPUT_SIZE; input++)
+        for (int hidden = 0; hidden < MLP_HIDDEN_SIZE; hidden++)
+            model->hidden_weights[input][hidden] = (random_float(&random) * 2 - 1) * hidden_scale;
+    for (int hidden = 0; hidden < MLP_HIDDEN_SIZE; hidden++)
+        model->output_weights[hidden] = (random_float(&random) * 2 - 1) * output_scale;
+}
+
+/*
+Calculates the hidden layer of one row before the activation
+The input is one-hot, so the product of the input and the hidden weights is the sum of one weight row for every cell
+*/
+void mlp_hidden_layer(const Mlp_Model *model, const ML_Data_Row *data_row, float hidden[MLP_HIDDEN_SIZE])
+{
+    memcpy(hidden, model->hidden_bias, sizeof(float) * MLP_HIDDEN_SIZE);
+
+    for (int cell = 0; cell < 9; cell++)
+    {
+        const float *weights = model->hidden_weights[cell * 3 + data_row->tile[cell]];
+        for (int i = 0; i < MLP_HIDDEN_SIZE; i++)
+            hidden[i] += weights[i];
+    }
+}
+
+/*
+Trains a copy of the model on one shard of the training rows for one epoch, ran by the worker threads of run_parallel
+Uses mini-batch SGD on the binary cross entropy between the predicted win probability and the result
+*/
+void mlp_train_task(int task_index, void *context)
+{
+    Mlp_Training *training = context;
+    Mlp_Model *model = &training->task_models[task_index];
+    int shard_start = (long long)task_index * training->data_count / MLP_TASK_COUNT;
+    int shard_end = (long long)(task_index + 1) * training->data_count / MLP_TASK_COUNT;
+
+    *model = *training->model;
+
+    for (int batch_start = shard_start; batch_start < shard_end; batch_start += MLP_BATCH_SIZE)
+    {
+        int batch_end = fmin(batch_start + MLP_BATCH_SIZE, shard_end);
+        Mlp_Model gradient;
+        memset(&gradient, 0, sizeof(gradient));
+
+        for (int row = batch_start; row < batch_end; row++)
+        {
+            const ML_Data_Row *data_row = &training->data_rows[row];
+            float hidden[MLP_HIDDEN_SIZE];
+            float output = model->output_bias;
+
+            // forward pass
+            mlp_hidden_layer(model, data_row, hidden);
+            for (int i = 0; i < MLP_HIDDEN_SIZE; i++)
+                output += fmaxf(hidden[i], 0) * model->output_weights[i];
+            float probability = 1 / (1 + expf(-output));
+
+            // backward pass, the gradient of the cross entropy through the sigmoid is the probability minus the result
+            float output_gradient = probability - (data_row->result == POSITIVE);
+            gradient.output_bias += output_gradient;
+            for (int i = 0; i < MLP_HIDDEN_SIZE; i++)
+            {
+                if (hidden[i] <= 0)
+                    continue;
+
+                float hidden_gradient = output_gradient * model->output_weights[i];
+                gradient.output_weights[i] += output_gradient * hidden[i];
+                gradient.hidden_bias[i] += hidden_gradient;
+                for (int cell = 0; cell < 9; cell++)
+                    gradient.hidden_weights[cell * 3 + data_row->tile[cell]][i] += hidden_gradient;
+            }
+        }
+
+        // step against the mean gradient of the batch
+        float step = MLP_LEARNING_RATE / (batch_end - batch_start);
+        float *parameters = (float *)model;
+        const float *gradients = (const float *)&gradient;
+        for (size_t i = 0; i < sizeof(Mlp_Model) / sizeof(float); i++)
+            parameters[i] -= step * gradients[i];
+    }
+}
+
+/*
+Trains the network on the rows for MLP_EPOCH_COUNT epochs
+Every epoch the rows are split into MLP_TASK_COUNT shards that are trained in parallel on copies of the model, and the copies are averaged
+*/
+void mlp_train(Mlp_Model *model, const ML_Data_Row data_rows[], int data_count, unsigned long long seed)
+{
+    Mlp_Training training = {model, NULL, data_rows, data_count};
+
+    training.task_models = malloc(sizeof(Mlp_Model) * MLP_TASK_COUNT);
+    if (training.task_models == NULL)
+    {
+        printf("Failed to allocate memory for the MLP training\n");
+        exit(1);
+    }
+
+    mlp_init(model, seed);
+
+    for (int epoch = 0; epoch < MLP_EPOCH_COUNT; epoch++)
+    {
+        run_parallel(mlp_train_task, MLP_TASK_COUNT, &training);
+
+        // average the parameters of the copies, a model is a flat array of floats
+        float *parameters = (float *)model;
+        for (size_t i = 0; i < sizeof(Mlp_Model) / sizeof(float); i++)
+        {
+            float sum = 0;
+            for (int task = 0; task < MLP_TASK_COUNT; task++)
+                sum += ((const float *)&training.task_models[task])[i];
+            parameters[i] = sum / MLP_TASK_COUNT;
+        }
+    }
+
+    free(training.task_models);
+}
+
+/*
+Scores count rows at once and writes the win probability of each row into predicted_results
+Uses AVX2 to compute 8 hidden units per instruction when compiled with -mavx2
+*/
+void mlp_predict_batch(const void *model_data, const ML_Data_Row data_rows[], int count, Predicted_Result predicted_results[])
+{
+    const Mlp_Model *model = model_data;
+
+    for (int i = 0; i < count; i++)
+    {
+        float output = model->output_bias;
+
+#if defined(__AVX2__)
+        __m256 hidden[MLP_HIDDEN_SIZE / 8];
+        for (int lane = 0; lane < MLP_HIDDEN_SIZE / 8; lane++)
+            hidden[lane] = _mm256_loadu_ps(&model->hidden_bias[lane * 8]);
+
+        // add the weight row of the tile of every cell
+        for (int cell = 0; cell < 9; cell++)
+        {
+            const float *weights = model->hidden_weights[cell * 3 + data_rows[i].tile[cell]];
+            for (int lane = 0; lane < MLP_HIDDEN_SIZE / 8; lane++)
+                hidden[lane] = _mm256_add_ps(hidden[lane], _mm256_loadu_ps(&weights[lane * 8]));
+        }
+
+        // relu and dot product with the output weights
+        __m256 sum = _mm256_setzero_ps();
+        for (int lane = 0; lane < MLP_HIDDEN_SIZE / 8; lane++)
+        {
+            __m256 activation = _mm256_max_ps(hidden[lane], _mm256_setzero_ps());
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(activation, _mm256_loadu_ps(&model->output_weights[lane * 8])));
+        }
+
+        float sum_lanes[8];
+        _mm256_storeu_ps(sum_lanes, sum);
+        for (int lane = 0; lane < 8; lane++)
+            output += sum_lanes[lane];
+#else
+        float hidden[MLP_HIDDEN_SIZE];
+        mlp_hidden_layer(model, &data_rows[i], hidden);
+        for (int j = 0; j < MLP_HIDDEN_SIZE; j++)
+            output += fmaxf(hidden[j], 0) * model->output_weights[j];
+#endif
+
+        // the score is the win probability, rows of at least 0.5 are predicted positive
+        predicted_results[i].score = 1 / (1 + expf(-output));
+        predicted_results[i].result = predicted_results[i].score >= 0.5 ? POSITIVE : NEGATIVE;
+    }
+}
+
+/*
+Returns the best move from the network, every empty cell is scored in one batch and the highest win probability is taken
+*/
+Move get_mlp_best_move()
+{
+    ML_Data_Row candidates[9];
+    Move candidate_moves[9];
+    Predicted_Result predicted_results[9];
+    int candidate_count = 0;
+
+    // get_current_grid() maps the AI tile to CROSS, so each candidate places a cross on an empty cell
+    ML_Data_Row current_row = get_current_grid();
+
+    for (int i = 0; i < ROW; i++)
+        for (int j = 0; j < COLUMN; j++)
+            if (g_grid[i][j] == EMPTY)
+            {
+                candidates[candidate_count] = current_row;
+                candidates[candidate_count].tile[i * 3 + j] = CROSS;
+                candidate_moves[candidate_count] = (Move){i, j};
+                candidate_count++;
+            }
+
+    if (g_mlp_quantized)
+        quantized_mlp_predict_batch(&g_quantized_mlp_model, candidates, candidate_count, predicted_results);
+    else
+        mlp_predict_batch(&g_mlp_model, candidates, candidate_count, predicted_results);
+
+    int best_candidate = 0;
+    for (int i = 1; i < candidate_count; i++)
+        if (predicted_results[i].score > predicted_results[best_candidate].score)
+            best_candidate = i;
+
+    return candidate_count > 0 ? candidate_moves[best_candidate] : (Move){-1, -1};
+}
+
+/*
+Quantizes the weights of a trained network to 8 bit integers with one scale for each layer
+The scale of a layer maps its largest weight to 127, the hidden bias uses the same scale as the hidden weights
+*/
+void mlp_quantize(const Mlp_Model *model, Quantized_Mlp_Model *quantized_model)
+{
+    float hidden_max = 0, output_max = 0;
+
+    for (int input = 0; input < MLP_INPUT_SIZE; input++)
+        for (int hidden = 0; hidden < MLP_HIDDEN_SIZE; hidden++)
+            hidden_max = fmaxf(hidden_max, fabsf(model->hidden_weights[input][hidden]));
+    for (int hidden = 0; hidden < MLP_HIDDEN_SIZE; hidden++)
+        output_max = fmaxf(output_max, fabsf(model->output_weights[hidden]));
+
+    quantized_model->hidden_scale = hidden_max > 0 ? hidden_max / 127 : 1;
+    quantized_model->output_scale = output_max > 0 ? output_max / 127 : 1;
+    quantized_model->output_bias = model->output_bias;
+
+    for (int input = 0; input < MLP_INPUT_SIZE; input++)
+        for (int hidden = 0; hidden < MLP_HIDDEN_SIZE; hidden++)
+            quantized_model->hidden_weights[input][hidden] = (signed char)lrintf(model->hidden_weights[input][hidden] / quantized_model->hidden_scale);
+
+    for (int hidden = 0; hidden < MLP_HIDDEN_SIZE; hidden++)
+    {
+        // the bias is limited so that adding the 9 weights of a board can never overflow a short
+        float bias = model->hidden_bias[hidden] / quantized_model->hidden_scale;
+        quantized_model->hidden_bias[hidden] = (short)lrintf(fmaxf(-MLP_QUANTIZED_BIAS_LIMIT, fminf(MLP_QUANTIZED_BIAS_LIMIT, bias)));
+        quantized_model->output_weights[hidden] = (short)lrintf(model->output_weights[hidden] / quantized_model->output_scale);
+    }
+}
+
+/*
+Scores count rows at once with the quantized network, same results as mlp_predict_batch() apart from the rounding of the weights
+The hidden layer is summed in shorts and the output in ints, with AVX2 computing 16 hidden units per instruction when compiled with -mavx2
+*/
+void quantized_mlp_predict_batch(const void *model_data, const ML_Data_Row data_rows[], int count, Predicted_Result predicted_results[])
+{
+    const Quantized_Mlp_Model *model = model_data;
+
+    for (int i = 0; i < count; i++)
+    {
+        int sum = 0;
+
+#if defined(__AVX2__)
+        __m256i hidden[MLP_HIDDEN_SIZE / 16];
+        for (int lane = 0; lane < MLP_HIDDEN_SIZE / 16; lane++)
+            hidden[lane] = _mm256_loadu_si256((const __m256i *)&model->hidden_bias[lane * 16]);
+
+        // sign extend the 16 weights of the tile of every cell to shorts and add them
+        for (int cell = 0; cell < 9; cell++)
+        {
+            const signed char *weights = model->hidden_weights[cell * 3 + data_rows[i].tile[cell]];
+            for (int lane = 0; lane < MLP_HIDDEN_SIZE / 16; lane++)
+                hidden[lane] = _mm256_add_epi16(hidden[lane], _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *)&weights[lane * 16])));
+        }
+
+        // relu, then multiply with the output weights and add pairs of products into ints
+        __m256i sums = _mm256_setzero_si256();
+        for (int lane = 0; lane < MLP_HIDDEN_SIZE / 16; lane++)
+        {
+            __m256i activation = _mm256_max_epi16(hidden[lane], _mm256_setzero_si256());
+            __m256i output_weights = _mm256_loadu_si256((const __m256i *)&model->output_weights[lane * 16]);
+            sums = _mm256_add_epi32(sums, _mm256_madd_epi16(activation, output_weights));
+        }
+
+        int sum_lanes[8];
+        _mm256_storeu_si256((__m256i *)sum_lanes, sums);
+        for (int lane = 0; lane < 8; lane++)
+            sum += sum_lanes[lane];
+#else
+        short hidden[MLP_HIDDEN_SIZE];
+        memcpy(hidden, model->hidden_bias, sizeof(hidden));
+        for (int cell = 0; cell < 9; cell++)
+        {
+            const signed char *weights = model->hidden_weights[cell * 3 + data_rows[i].tile[cell]];
+            for (int j = 0; j < MLP_HIDDEN_SIZE; j++)
+                hidden[j] += weights[j];
+        }
+        for (int j = 0; j < MLP_HIDDEN_SIZE; j++)
+            if (hidden[j] > 0)
+                sum += hidden[j] * model->output_weights[j];
+#endif
+
+        // scale the integer sum back to a float before the sigmoid
+        float output = sum * model->hidden_scale * model->output_scale + model->output_bias;
+        predicted_results[i].score = 1 / (1 + expf(-output));
+        predicted_results[i].result = predicted_results[i].score >= 0.5 ? POSITIVE : NEGATIVE;
+    }
+}
+
+/*
+Trains a network on the shuffled dataset and quantizes it, then reports the accuracy of both models on the test data
+Also times both kernels over every possible board and reports the size of the weights
+The naive bayes model is trained on the same rows and compared with its int16 quantization in the same way
+*/
+void run_mlp_calibration(unsigned int seed)
+{
+    static Mlp_Model model;
+    static Quantized_Mlp_Model quantized_model;
+    static Naive_Bayes_Model naive_bayes_model;
+    static Quantized_Naive_Bayes_Model quantized_naive_bayes_model;
+    static ML_Data_Row boards[BOARD_STATE_COUNT];
+    static Predicted_Result predicted_results[BOARD_STATE_COUNT];
+
+    Random random;
+    random_seed(&random, seed);
+    shuffle_dataset(&random);
+    int training_count = ceil(g_dataset_count * TRAINING_DATA_WEIGHT);
+    int test_count = g_dataset_count - training_count;
+
+    mlp_train(&model, gp_dataset_array, training_count, seed);
+    mlp_quantize(&model, &quantized_model);
+
+    Confusion_Matrix confusion_matrix = count_confusion_matrix(mlp_predict_batch, &model, &gp_dataset_array[training_count], test_count);
+    Confusion_Matrix quantized_confusion_matrix = count_confusion_matrix(quantized_mlp_predict_batch, &quantized_model, &gp_dataset_array[training_count], test_count);
+    normalize_confusion_matrix(&confusion_matrix);
+    normalize_confusion_matrix(&quantized_confusion_matrix);
+
+    // decode every possible board so that both kernels are timed on the same rows
+    int agreement_count = 0;
+    for (int board_index = 0; board_index < BOARD_STATE_COUNT; board_index++)
+    {
+        for (int i = 0, digits = board_index; i < 9; i++, digits /= 3)
+            boards[board_index].tile[i] = digits % 3;
+        boards[board_index].board_index = board_index;
+    }
+
+    double start_time = get_monotonic_time();
+    for (int repeat = 0; repeat < MLP_CALIBRATION_REPEATS; repeat++)
+        mlp_predict_batch(&model, boards, BOARD_STATE_COUNT, predicted_results);
+    double float_time = get_monotonic_time() - start_time;
+
+    Data_Result float_results[BOARD_STATE_COUNT];
+    for (int board_index = 0; board_index < BOARD_STATE_COUNT; board_index++)
+        float_results[board_index] = predicted_results[board_index].result;
+
+    start_time = get_monotonic_time();
+    for (int repeat = 0; repeat < MLP_CALIBRATION_REPEATS; repeat++)
+        quantized_mlp_predict_batch(&quantized_model, boards, BOARD_STATE_COUNT, predicted_results);
+    double quantized_time = get_monotonic_time() - start_time;
+
+    for (int board_index = 0; board_index < BOARD_STATE_COUNT; board_index++)
+        agreement_count += predicted_results[board_index].result == float_results[board_index];
+
+    double board_count = (double)BOARD_STATE_COUNT * MLP_CALIBRATION_REPEATS;
+    printf("float: accuracy %f, %d bytes of weights, %.1f ns per board\n",
+           confusion_matrix.accuracy, (int)sizeof(model), float_time / board_count * 1e9);
+    printf("int8:  accuracy %f, %d bytes of weights, %.1f ns per board\n",
+           quantized_confusion_matrix.accuracy, (int)sizeof(quantized_model), quantized_time / board_count * 1e9);
+    printf("accuracy delta %+f, same prediction on %d of %d boards\n",
+           quantized_confusion_matrix.accuracy - confusion_matrix.accuracy, agreement_count, BOARD_STATE_COUNT);
+
+    // the naive bayes model is compared without its prediction table, so that the kernels themselves are timed
+    naive_bayes_reset(&naive_bayes_model);
+    naive_bayes_count(&naive_bayes_model, gp_dataset_array, NULL, training_count);
+    naive_bayes_finalize(&naive_bayes_model);
+    naive_bayes_quantize(&naive_bayes_model, &quantized_naive_bayes_model);
+
+    confusion_matrix = count_confusion_matrix(naive_bayes_predict_rows, &naive_bayes_model, &gp_dataset_array[training_count], test_count);
+    quantized_confusion_matrix = count_confusion_matrix(quantized_naive_bayes_predict_batch, &quantized_naive_bayes_model, &gp_dataset_array[training_count], test_count);
+    normalize_confusion_matrix(&confusion_matrix);
+    normalize_confusion_matrix(&quantized_confusion_matrix);
+
+    start_time = get_monotonic_time();
+    for (int repeat = 0; repeat < MLP_CALIBRATION_REPEATS; repeat++)
+        naive_bayes_predict_batch(&naive_bayes_model, boards, BOARD_STATE_COUNT, predicted_results);
+    float_time = get_monotonic_time() - start_time;
+
+    for (int board_index = 0; board_index < BOARD_STATE_COUNT; board_index++)
+        float_results[board_index] = predicted_results[board_index].result;
+
+    start_time = get_monotonic_time();
+    for (int repeat = 0; repeat < MLP_CALIBRATION_REPEATS; repeat++)
+        quantized_naive_bayes_predict_batch(&quantized_naive_bayes_model, boards, BOARD_STATE_COUNT, predicted_results);
+    quantized_time = get_monotonic_time() - start_time;
+
+    agreement_count = 0;
+    for (int board_index = 0; board_index < BOARD_STATE_COUNT; board_index++)
+        agreement_count += predicted_results[board_index].result == float_results[board_index];
+
+    printf("naive bayes float: accuracy %f, %d bytes of log probabilities, %.1f ns per board\n",
+           confusion_matrix.accuracy, (int)(sizeof(naive_bayes_model.log_table) + sizeof(naive_bayes_model.log_prior)), float_time / board_count * 1e9);
+    printf("naive bayes int16: accuracy %f, %d bytes of log probabilities, %.1f ns per board\n",
+           quantized_confusion_matrix.accuracy, (int)sizeof(quantized_naive_bayes_model), quantized_time / board_count * 1e9);
+    printf("accuracy delta %+f, same prediction on %d of %d boards\n",
+           quantized_confusion_matrix.accuracy - confusion_matrix.accuracy, agreement_count, BOARD_STATE_COUNT);
+}
+
+/*
+Returns the confusion matrix of the current dataset {TP, FP, TN, FN, probability_error, accuracy}
+*/
+Confusion_Matrix calculate_confusion_matrix()
+{
+    int data_count = floor(g_dataset_count * (1 - TRAINING_DATA_WEIGHT));
+
+    // the test data is the last 1 - TRAINING_DATA_WEIGHT % of the dataset_array, predicted from the table
+    prepare_naive_bayes_table();
+    const Naive_Bayes_Model *model = acquire_naive_bayes_model();
+    Confusion_Matrix confusion_matrix = count_confusion_matrix(naive_bayes_predict_rows, model, &gp_dataset_array[g_dataset_count - data_count], data_count);
+    release_naive_bayes_model(model);
+    normalize_confusion_matrix(&confusion_matrix);
+
+    return confusion_matrix;
+}
+
+/*
+Predicts every test row one batch at a time with predict_batch, which is given model_data, and counts the TP, FP, TN and FN
+The values are the number of rows, use normalize_confusion_matrix to turn them into probabilities
+*/
+Confusion_Matrix count_confusion_matrix(void (*predict_batch)(const void *model_data, const ML_Data_Row data_rows[], int count, Predicted_Result predicted_results[]), const void *model_data, const ML_Data_Row test_rows[], int data_count)
+{
+    // initialize confusion matrix
+    Confusion_Matrix confusion_matrix = {0, 0, 0, 0, 0, 0};
+    Predicted_Result predicted_results[PREDICT_BATCH_SIZE];
+
+    for (int batch_start = 0; batch_start < data_count; batch_start += PREDICT_BATCH_SIZE)
+    {
+        int batch_count = fmin(PREDICT_BATCH_SIZE, data_count - batch_start);
+        predict_batch(model_data, &test_rows[batch_start], batch_count, predicted_results);
+
+        for (int i = 0; i < batch_count; i++)
+            add_to_confusion_matrix(&confusion_matrix, test_rows[batch_start + i].result, predicted_results[i].result);
+    }
+
+    return confusion_matrix;
+}
+
+/*
+Counts one prediction into the TP, FP, TN or FN of the confusion matrix
+*/
+void add_to_confusion_matrix(Confusion_Matrix *confusion_matrix, Data_Result actual_result, Data_Result predicted_result)
+{
+    if (predicted_result == actual_result)
+    {
+        if (predicted_result == POSITIVE)
+            // predicted result is positive and actual result is positive
+            confusion_matrix->true_positive++;
+        else
+            // predicted result is negative and actual result is negative
+            confusion_matrix->true_negative++;
+    }
+    else
+    {
+        if (predicted_result == POSITIVE)
+            // predicted result is positive and actual result is negative
+            confusion_matrix->false_positive++;
+        else
+            // predicted result is negative and actual result is positive
+            confusion_matrix->false_negative++;
+    }
+}
+
+/*
+Turns the counts of a confusion matrix into probabilities and calculates the probability error and accuracy
+*/
+void normalize_confusion_matrix(Confusion_Matrix *confusion_matrix)
+{
+    double data_count = confusion_matrix->true_positive + confusion_matrix->true_negative + confusion_matrix->false_positive + confusion_matrix->false_negative;
+
+    // divide the total count of each result by the total data count to get the probability
+    confusion_matrix->true_positive /= data_count;
+    confusion_matrix->true_negative /= data_count;
+    confusion_matrix->false_positive /= data_count;
+    confusion_matrix->false_negative /= data_count;
+
+    // probability error is the sum of false positive and false negative, where the model makes a mistake
+    confusion_matrix->probability_error = confusion_matrix->false_positive + confusion_matrix->false_negative;
+    // accuracy is calculated as the number of all correct predictions divided by the total number of the datase
+    confusion_matrix->accuracy = (confusion_matrix->true_positive + confusion_matrix->true_negative) / (confusion_matrix->true_positive + confusion_matrix->true_negative + confusion_matrix->probability_error);
+}
+
+/*
+Writes the log odds log p(P | row) - log p(N | row) of every row, the higher the score the more likely the row is positive
+A row that is impossible under both results has no odds and gets a score of 0
+*/
+void naive_bayes_score_rows(const Naive_Bayes_Model *model, const ML_Data_Row data_rows[], int count, float scores[])
+{
+    for (int i = 0; i < count; i++)
+    {
+        double row_scores[2];
+        naive_bayes_row_scores(model, &data_rows[i], row_scores);
+
+        double score = row_scores[POSITIVE] - row_scores[NEGATIVE];
+        scores[i] = isnan(score) ? 0 : score;
+    }
+}
+
+/*
+Maps the bits of a float to an unsigned int with the same order, so that scores can be sorted as integers
+Positive floats get the sign bit set, negative floats have every bit flipped as a larger magnitude is a lower score
+*/
+unsigned int score_to_key(float score)
+{
+    unsigned int bits;
+    memcpy(&bits, &score, sizeof(bits));
+
+    return bits & 0x80000000u ? ~bits : bits | 0x80000000u;
+}
+
+/*
+Inverse of score_to_key()
+*/
+float key_to_score(unsigned int key)
+{
+    unsigned int bits = key & 0x80000000u ? key & ~0x80000000u : ~key;
+    float score;
+    memcpy(&score, &bits, sizeof(score));
+
+    return score;
+}
+
+/*
+Sorts the items by their top 32 bits with a least significant digit radix sort, one byte per pass
+The buffer must have room for count items, the sorted items end up back in items
+*/
+void radix_sort(unsigned long long items[], unsigned long long buffer[], int count)
+{
+    unsigned long long *source = items, *destination = buffer;
+
+    for (int shift = 32; shift < 64; shift += 8)
+    {
+        int offsets[256] = {0};
+
+        // count the items of each digit, then turn the counts into the first position of each digit
+        for (int i = 0; i < count; i++)
+            offsets[(source[i] >> shift) & 0xFF]++;
+        for (int digit = 0, position = 0; digit < 256; digit++)
+        {
+            int digit_count = offsets[digit];
+            offsets[digit] = position;
+            position += digit_count;
+        }
+
+        // the copy keeps the order of items with the same digit, so the earlier passes stay sorted
+        for (int i = 0; i < count; i++)
+            destination[offsets[(source[i] >> shift) & 0xFF]++] = source[i];
+
+        unsigned long long *swap = source;
+        source = destination;
+        destination = swap;
+    }
+}
+
+/*
+Calculates the ROC curve of the scores against the actual results of the rows
+The scores are sorted once, then every distinct score is used as a threshold from the highest to the lowest
+A row is predicted positive if its score is at least the threshold, the threshold with the highest accuracy is the best threshold
+*/
+Roc_Curve calculate_roc_curve(const float scores[], const Data_Result results[], int count)
+{
+    Roc_Curve curve = {NULL, NULL, 0, 0, INFINITY, 0};
+    unsigned long long *items = malloc(sizeof(unsigned long long) * (count + 1));
+    unsigned long long *buffer = malloc(sizeof(unsigned long long) * (count + 1));
+    curve.false_positive_rates = malloc(sizeof(float) * (count + 1));
+    curve.true_positive_rates = malloc(sizeof(float) * (count + 1));
+
+    if (!items || !buffer || !curve.false_positive_rates || !curve.true_positive_rates)
+    {
+        printf("Error allocating memory for the ROC curve of %d rows\n", count);
+        exit(1);
+    }
+
+    // the key of the score is in the top 32 bits and the result in the lowest bit
+    int positive_count = 0;
+    for (int i = 0; i < count; i++)
+    {
+        items[i] = (unsigned long long)score_to_key(scores[i]) << 32 | results[i];
+        positive_count += results[i] == POSITIVE;
+    }
+    int negative_count = count - positive_count;
+    radix_sort(items, buffer, count);
+
+    // start with a threshold above every score, where every row is predicted negative
+    int true_positive = 0, false_positive = 0;
+    curve.false_positive_rates[0] = 0;
+    curve.true_positive_rates[0] = 0;
+    curve.point_count = 1;
+    curve.best_accuracy = count > 0 ? (double)negative_count / count : 0;
+
+    for (int i = count - 1; i >= 0;)
+    {
+        // every row with the same score changes prediction at the same threshold
+        unsigned int key = items[i] >> 32;
+        for (; i >= 0 && (items[i] >> 32) == key; i--)
+        {
+            if ((items[i] & 1) == POSITIVE)
+                true_positive++;
+            else
+                false_positive++;
+        }
+
+        float false_positive_rate = negative_count > 0 ? (float)false_positive / negative_count : 0;
+        float true_positive_rate = positive_count > 0 ? (float)true_positive / positive_count : 0;
+
+        // add the area under the line from the previous point with the trapezoid rule
+        int previous = curve.point_count - 1;
+        curve.auc += (false_positive_rate - curve.false_positive_rates[previous]) * (true_positive_rate + curve.true_positive_rates[previous]) / 2;
+        curve.false_positive_rates[curve.point_count] = false_positive_rate;
+        curve.true_positive_rates[curve.point_count] = true_positive_rate;
+        curve.point_count++;
+
+        double accuracy = (double)(true_positive + negative_count - false_positive) / count;
+        if (accuracy > curve.best_accuracy)
+        {
+            curve.best_accuracy = accuracy;
+            curve.best_threshold = key_to_score(key);
+        }
+    }
+
+    free(items);
+    free(buffer);
+
+    return curve;
+}
+
+/*
+Frees the points of the ROC curve
+*/
+void free_roc_curve(Roc_Curve *curve)
+{
+    free(curve->false_positive_rates);
+    free(curve->true_positive_rates);
+    curve->false_positive_rates = NULL;
+    curve->true_positive_rates = NULL;
+    curve->point_count = 0;
+}
+
+/*
+Returns the ROC curve of the naive bayes model on the test data, the same rows as calculate_confusion_matrix()
+*/
+Roc_Curve calculate_naive_bayes_roc_curve()
+{
+    int data_count = floor(g_dataset_count * (1 - TRAINING_DATA_WEIGHT));
+    const ML_Data_Row *test_rows = &gp_dataset_array[g_dataset_count - data_count];
+    float *scores = malloc(sizeof(float) * (data_count + 1));
+    Data_Result *results = malloc(sizeof(Data_Result) * (data_count + 1));
+
+    if (!scores || !results)
+    {
+        printf("Error allocating memory for the scores of %d rows\n", data_count);
+        exit(1);
+    }
+
+    const Naive_Bayes_Model *model = acquire_naive_bayes_model();
+    naive_bayes_score_rows(model, test_rows, data_count, scores);
+    release_naive_bayes_model(model);
+
+    for (int i = 0; i < data_count; i++)
+        results[i] = test_rows[i].result;
+    Roc_Curve curve = calculate_roc_curve(scores, results, data_count);
+
+    free(scores);
+    free(results);
+
+    return curve;
+}
+
+/*
+Returns the ROC curve of the neural network on the test data, the score of a row is its win probability
+The quantized network is used when quantized_model is not NULL
+*/
+Roc_Curve calculate_mlp_roc_curve(const Mlp_Model *model, const Quantized_Mlp_Model *quantized_model, const ML_Data_Row test_rows[], int data_count)
+{
+    float *scores = malloc(sizeof(float) * (data_count + 1));
+    Data_Result *results = malloc(sizeof(Data_Result) * (data_count + 1));
+
+    if (!scores || !results)
+    {
+        printf("Error allocating memory for the scores of %d rows\n", data_count);
+        exit(1);
+    }
+
+    Predicted_Result predicted_results[PREDICT_BATCH_SIZE];
+    for (int batch_start = 0; batch_start < data_count; batch_start += PREDICT_BATCH_SIZE)
+    {
+        int batch_count = fmin(PREDICT_BATCH_SIZE, data_count - batch_start);
+        if (quantized_model != NULL)
+            quantized_mlp_predict_batch(quantized_model, &test_rows[batch_start], batch_count, predicted_results);
+        else
+            mlp_predict_batch(model, &test_rows[batch_start], batch_count, predicted_results);
+
+        for (int i = 0; i < batch_count; i++)
+        {
+            scores[batch_start + i] = predicted_results[i].score;
+            results[batch_start + i] = test_rows[batch_start + i].result;
+        }
+    }
+
+    Roc_Curve curve = calculate_roc_curve(scores, results, data_count);
+
+    free(scores);
+    free(results);
+
+    return curve;
+}
+
+/*
+Draws the ROC curve into the bounds, with the false positive rate going right and the true positive rate going up
+The dashed diagonal is the curve of a model that guesses at random
+*/
+void render_roc_curve(const Roc_Curve *curve, Rectangle bounds)
+{
+    DrawRectangleLinesEx(bounds, 1, TITLE_COLOUR);
+    for (int i = 0; i < 10; i += 2)
+        DrawLineV((Vector2){bounds.x + bounds.width * i / 10, bounds.y + bounds.height * (10 - i) / 10},
+                  (Vector2){bounds.x + bounds.width * (i + 1) / 10, bounds.y + bounds.height * (9 - i) / 10}, Fade(TITLE_COLOUR, 0.4f));
+
+    for (int i = 1; i < curve->point_count; i++)
+    {
+        Vector2 start = {bounds.x + curve->false_positive_rates[i - 1] * bounds.width, bounds.y + (1 - curve->true_positive_rates[i - 1]) * bounds.height};
+        Vector2 end = {bounds.x + curve->false_positive_rates[i] * bounds.width, bounds.y + (1 - curve->true_positive_rates[i]) * bounds.height};
+        DrawLineEx(start, end, 2, TITLE_COLOUR);
+    }
+}
+
+/*
+Trains the naive bayes model on the shuffled dataset and prints the ROC curve of the test data as csv
+Followed by the AUC and the threshold of the log odds with the highest accuracy
+*/
+void run_roc_evaluation(unsigned int seed)
+{
+    Random random;
+    random_seed(&random, seed);
+    shuffle_dataset(&random);
+    naive_bayes_learn(TRAINING_DATA_WEIGHT);
+
+    Roc_Curve curve = calculate_naive_bayes_roc_curve();
+    Confusion_Matrix confusion_matrix = calculate_confusion_matrix();
+
+    printf("false_positive_rate,true_positive_rate\n");
+    for (int i = 0; i < curve.point_count; i++)
+        printf("%f,%f\n", curve.false_positive_rates[i], curve.true_positive_rates[i]);
+    printf("seed %u, AUC %f, best threshold %g with accuracy %f, accuracy at the default threshold %f\n",
+           seed, curve.auc, curve.best_threshold, curve.best_accuracy, confusion_matrix.accuracy);
+
+    free_roc_curve(&curve);
+}
+
+/*
+Builds the node of a decision tree for the rows in indices and its children, returns the index of the node
+The split is chosen from a histogram of the results of each of the 3 tiles of a random subset of the cells
+The node becomes a leaf when it is pure, too small, too deep, or no cell reduces the gini impurity
+*/
+int build_tree_node(Tree_Builder *builder, int indices[], int count, int depth, float parent_probability)
+{
+    int node_index = builder->node_count++;
+    Tree_Node *node = &builder->nodes[node_index];
+    int positive_count = 0;
+
+    for (int i = 0; i < count; i++)
+        positive_count += builder->data_rows[indices[i]].result == POSITIVE;
+
+    // an empty child predicts the same as its parent
+    node->cell = -1;
+    node->positive_probability = count > 0 ? (float)positive_count / count : parent_probability;
+    if (count < FOREST_MIN_SPLIT || depth >= FOREST_MAX_DEPTH || positive_count == 0 || positive_count == count)
+        return node_index;
+
+    // pick FOREST_FEATURE_COUNT different cells by partially shuffling the cells
+    int cells[9] = {0, 1, 2, 3, 4, 5, 6, 7, 8};
+    for (int i = 0; i < FOREST_FEATURE_COUNT; i++)
+    {
+        int j = i + random_below(&builder->random, 9 - i);
+        int temp_cell = cells[i];
+        cells[i] = cells[j];
+        cells[j] = temp_cell;
+    }
+
+    // the impurity is the gini impurity multiplied by the number of rows, so that children can be summed
+    double best_impurity = count - (double)(positive_count * positive_count + (count - positive_count) * (count - positive_count)) / count - 1e-9;
+    int best_cell = -1;
+
+    for (int i = 0; i < FOREST_FEATURE_COUNT; i++)
+    {
+        int histogram[3][2] = {{0}};
+        for (int row = 0; row < count; row++)
+        {
+            const ML_Data_Row *data_row = &builder->data_rows[indices[row]];
+            histogram[data_row->tile[cells[i]]][data_row->result]++;
+        }
+
+        double impurity = 0;
+        for (int tile = 0; tile < 3; tile++)
+        {
+            int tile_count = histogram[tile][NEGATIVE] + histogram[tile][POSITIVE];
+            if (tile_count > 0)
+                impurity += tile_count - (double)(histogram[tile][NEGATIVE] * histogram[tile][NEGATIVE] + histogram[tile][POSITIVE] * histogram[tile][POSITIVE]) / tile_count;
+        }
+
+        if (impurity < best_impurity)
+        {
+            best_impurity = impurity;
+            best_cell = cells[i];
+        }
+    }
+
+    if (best_cell < 0)
+        return node_index;
+
+    // partition the indices by the tile of the best cell, EMPTY rows first, then CROSS, then CIRCLE
+    int low = 0, middle = 0, high = count - 1;
+    while (middle <= high)
+    {
+        Tile tile = builder->data_rows[indices[middle]].tile[best_cell];
+        int temp_index = indices[middle];
+
+        if (tile == EMPTY)
+        {
+            indices[middle++] = indices[low];
+            indices[low++] = temp_index;
+        }
+        else if (tile == CIRCLE)
+        {
+            indices[middle] = indices[high];
+            indices[high--] = temp_index;
+        }
+        else
+            middle++;
+    }
+
+    // the children are built after the node, so the node is looked up again as the array is not moved
+    float probability = node->positive_probability;
+    int child_empty = build_tree_node(builder, indices, low, depth + 1, probability);
+    int child_cross = build_tree_node(builder, &indices[low], middle - low, depth + 1, probability);
+    int child_circle = build_tree_node(builder, &indices[middle], count - middle, depth + 1, probability);
+
+    node = &builder->nodes[node_index];
+    node->cell = best_cell;
+    node->children[EMPTY] = child_empty;
+    node->children[CROSS] = child_cross;
+    node->children[CIRCLE] = child_circle;
+
+    return node_index;
+}
+
+/*
+Trains one tree of the forest on a bootstrap sample of the training rows, ran by the worker threads of run_parallel
+*/
+void train_forest_tree(int tree, void *context)
+{
+    Forest_Training *training = context;
+    Tree_Builder builder;
+    int *indices = malloc(sizeof(int) * (training->data_count + 1));
+
+    // a split leaves at least 2 rows in different children, so a tree of n rows has at most 3n + 1 nodes
+    builder.data_rows = training->data_rows;
+    builder.nodes = malloc(sizeof(Tree_Node) * (3 * training->data_count + 1));
+    builder.node_count = 0;
+    random_seed(&builder.random, training->seed + tree);
+
+    if (!indices || !builder.nodes)
+    {
+        printf("Error allocating memory for tree %d\n", tree);
+        exit(1);
+    }
+
+    // sample the rows with replacement, so that every tree sees a different dataset
+    for (int i = 0; i < training->data_count; i++)
+        indices[i] = random_below(&builder.random, training->data_count);
+
+    build_tree_node(&builder, indices, training->data_count, 0, 0.5f);
+
+    training->tree_nodes[tree] = builder.nodes;
+    training->tree_node_counts[tree] = builder.node_count;
+    free(indices);
+}
+
+/*
+Trains FOREST_TREE_COUNT trees in parallel and copies them into one flat array of nodes
+The children indices of each tree are moved by the position of the tree in the array
+*/
+void train_random_forest(Random_Forest *forest, const ML_Data_Row data_rows[], int data_count, unsigned long long seed)
+{
+    Forest_Training training = {data_rows, data_count, seed, {NULL}, {0}};
+
+    run_parallel(train_forest_tree, FOREST_TREE_COUNT, &training);
+
+    forest->node_count = 0;
+    for (int tree = 0; tree < FOREST_TREE_COUNT; tree++)
+        forest->node_count += training.tree_node_counts[tree];
+
+    free(forest->nodes);
+    forest->nodes = malloc(sizeof(Tree_Node) * (forest->node_count + 1));
+    if (!forest->nodes)
+    {
+        printf("Error allocating memory for %d forest nodes\n", forest->node_count);
+        exit(1);
+    }
+
+    int offset = 0;
+    for (int tree = 0; tree < FOREST_TREE_COUNT; tree++)
+    {
+        forest->roots[tree] = offset;
+        for (int i = 0; i < training.tree_node_counts[tree]; i++)
+        {
+            Tree_Node node = training.tree_nodes[tree][i];
+            for (int tile = 0; tile < 3 && node.cell >= 0; tile++)
+                node.children[tile] += offset;
+            forest->nodes[offset + i] = node;
+        }
+
+        offset += training.tree_node_counts[tree];
+        free(training.tree_nodes[tree]);
+    }
+}
+
+/*
+Scores count rows at once, the score is the positive probability averaged over every tree
+Each tree is walked by indexing the children with the tile of the split cell, so there is no branch on the tile
+*/
+void forest_predict_batch(const Random_Forest *forest, const ML_Data_Row data_rows[], int count, Predicted_Result predicted_results[])
+{
+    for (int i = 0; i < count; i++)
+    {
+        float probability_sum = 0;
+
+        for (int tree = 0; tree < FOREST_TREE_COUNT; tree++)
+        {
+            int node = forest->roots[tree];
+            while (forest->nodes[node].cell >= 0)
+                node = forest->nodes[node].children[data_rows[i].tile[forest->nodes[node].cell]];
+            probability_sum += forest->nodes[node].positive_probability;
+        }
+
+        predicted_results[i].score = probability_sum / FOREST_TREE_COUNT;
+        predicted_results[i].result = predicted_results[i].score >= 0.5 ? POSITIVE : NEGATIVE;
+    }
+}
+
+/*
+Predicts the test rows with the forest, then counts the confusion matrix and calculates the ROC curve of the predictions
+*/
+Confusion_Matrix evaluate_random_forest(const Random_Forest *forest, const ML_Data_Row test_rows[], int data_count, Roc_Curve *roc_curve)
+{
+    Confusion_Matrix confusion_matrix = {0, 0, 0, 0, 0, 0};
+    Predicted_Result *predicted_results = malloc(sizeof(Predicted_Result) * (data_count + 1));
+    float *scores = malloc(sizeof(float) * (data_count + 1));
+    Data_Result *results = malloc(sizeof(Data_Result) * (data_count + 1));
+
+    if (!predicted_results || !scores || !results)
+    {
+        printf("Error allocating memory for the predictions of %d rows\n", data_count);
+        exit(1);
+    }
+
+    forest_predict_batch(forest, test_rows, data_count, predicted_results);
+    for (int i = 0; i < data_count; i++)
+    {
+        add_to_confusion_matrix(&confusion_matrix, test_rows[i].result, predicted_results[i].result);
+        scores[i] = predicted_results[i].score;
+        results[i] = test_rows[i].result;
+    }
+    normalize_confusion_matrix(&confusion_matrix);
+    *roc_curve = calculate_roc_curve(scores, results, data_count);
+
+    free(predicted_results);
+    free(scores);
+    free(results);
+
+    return confusion_matrix;
+}
+
+/*
+Returns the best move from the forest, every empty cell is scored in one batch and the highest positive probability is taken
+*/
+Move get_forest_best_move()
+{
+    ML_Data_Row candidates[9];
+    Move candidate_moves[9];
+    Predicted_Result predicted_results[9];
+    int candidate_count = 0;
+
+    // get_current_grid() maps the AI tile to CROSS, so each candidate places a cross on an empty cell
+    ML_Data_Row current_row = get_current_grid();
+
+    for (int i = 0; i < ROW; i++)
+        for (int j = 0; j < COLUMN; j++)
+            if (g_grid[i][j] == EMPTY)
+            {
+                candidates[candidate_count] = current_row;
+                candidates[candidate_count].tile[i * 3 + j] = CROSS;
+                candidate_moves[candidate_count] = (Move){i, j};
+                candidate_count++;
+            }
+
+    forest_predict_batch(&g_random_forest, candidates, candidate_count, predicted_results);
+
+    int best_candidate = 0;
+    for (int i = 1; i < candidate_count; i++)
+        if (predicted_results[i].score > predicted_results[best_candidate].score)
+            best_candidate = i;
+
+    return candidate_count > 0 ? candidate_moves[best_candidate] : (Move){-1, -1};
+}
+
+/*
+Trains and evaluates one fold of the cross validation, ran by the worker threads of run_parallel
+The fold is used as the test data and the rest of the dataset as the training data
+*/
+void cross_validation_fold(int fold, void *context)
+{
+    Cross_Validation *cross_validation = context;
+    int fold_start = (long long)fold * cross_validation->data_count / cross_validation->fold_count;
+    int fold_end = (long long)(fold + 1) * cross_validation->data_count / cross_validation->fold_count;
+
+    // each fold trains its own model so that the folds do not share any state
+    Naive_Bayes_Model *model = malloc(sizeof(Naive_Bayes_Model));
+    ML_Data_Row *test_rows = malloc(sizeof(ML_Data_Row) * (fold_end - fold_start + 1));
+    if (!model || !test_rows)
+    {
+        printf("Error allocating memory for fold %d\n", fold);
+        exit(1);
+    }
+
+    // train on the rows before and after the fold in the random order
+    naive_bayes_reset(model);
+    naive_bayes_count(model, cross_validation->data_rows, cross_validation->order, fold_start);
+    naive_bayes_count(model, cross_validation->data_rows, &cross_validation->order[fold_end], cross_validation->data_count - fold_end);
+    naive_bayes_finalize(model);
+    // the table costs a prediction of every board, so it only pays off for folds with more rows than boards
+    if (fold_end - fold_start >= BOARD_STATE_COUNT)
+        naive_bayes_build_table(model);
+
+    // gather the rows of the fold so that they can be predicted in batches, then test on them
+    for (int i = fold_start; i < fold_end; i++)
+        test_rows[i - fold_start] = cross_validation->data_rows[cross_validation->order[i]];
+    cross_validation->fold_counts[fold] = count_confusion_matrix(naive_bayes_predict_rows, model, test_rows, fold_end - fold_start);
+
+    free(test_rows);
+    free(model);
+}
+
+/*
+Runs k fold cross validation on the dataset with the folds trained and evaluated in parallel
+Prints the confusion matrix of every fold, the aggregated confusion matrix and the mean and variance of the accuracy
+*/
+void run_cross_validation(int fold_count, unsigned int seed)
+{
+    Cross_Validation cross_validation = {gp_dataset_array, NULL, g_dataset_count, fold_count, NULL};
+
+    if (fold_count < 2 || fold_count > g_dataset_count)
+    {
+        printf("Number of folds must be between 2 and %d\n", g_dataset_count);
+        exit(1);
+    }
+
+    cross_validation.fold_counts = calloc(fold_count, sizeof(Confusion_Matrix));
+    if (!cross_validation.fold_counts)
+    {
+        printf("Error allocating memory for %d folds\n", fold_count);
+        exit(1);
+    }
+
+    // shuffle the order of the rows with the seed so that the same seed always gives the same folds
+    Random random;
+    random_seed(&random, seed);
+    int *order = create_permutation(g_dataset_count, &random);
+    cross_validation.order = order;
+    run_parallel(cross_validation_fold, fold_count, &cross_validation);
+
+    Confusion_Matrix aggregated = {0, 0, 0, 0, 0, 0};
+    double accuracy_sum = 0, accuracy_square_sum = 0;
+
+    printf("fold,TP,FP,TN,FN,accuracy\n");
+    for (int fold = 0; fold < fold_count; fold++)
+    {
+        Confusion_Matrix fold_matrix = cross_validation.fold_counts[fold];
+
+        // sum the counts of every fold before they are normalized
+        aggregated.true_positive += fold_matrix.true_positive;
+        aggregated.false_positive += fold_matrix.false_positive;
+        aggregated.true_negative += fold_matrix.true_negative;
+        aggregated.false_negative += fold_matrix.false_negative;
+
+        normalize_confusion_matrix(&fold_matrix);
+        accuracy_sum += fold_matrix.accuracy;
+        accuracy_square_sum += fold_matrix.accuracy * fold_matrix.accuracy;
+
+        printf("%d,%f,%f,%f,%f,%f\n", fold, fold_matrix.true_positive, fold_matrix.false_positive, fold_matrix.true_negative, fold_matrix.false_negative, fold_matrix.accuracy);
+    }
+
+    normalize_confusion_matrix(&aggregated);
+    printf("all,%f,%f,%f,%f,%f\n", aggregated.true_positive, aggregated.false_positive, aggregated.true_negative, aggregated.false_negative, aggregated.accuracy);
+
+    // sample variance of the accuracy between the folds
+    double accuracy_mean = accuracy_sum / fold_count;
+    double accuracy_variance = (accuracy_square_sum - fold_count * accuracy_mean * accuracy_mean) / (fold_count - 1);
+    printf("seed %u, %d folds, mean accuracy %f, variance %g\n", seed, fold_count, accuracy_mean, accuracy_variance);
+
+    free(cross_validation.fold_counts);
+    free(order);
+}
+
+/*
+Trains and evaluates the configuration at config_indices[task_index] of the sweep
+The first training_weight of the shared dataset is used as the training data and the rest as the test data
+Single threaded models are timed with the cpu time of their thread, as other configurations run on the other cores at the same time
+*/
+void sweep_config_task(int task_index, void *context)
+{
+    Sweep *sweep = context;
+    int config_index = sweep->config_indices[task_index];
+    Sweep_Config *config = &sweep->configs[config_index];
+    double (*get_time)() = config->multithreaded ? get_monotonic_time : get_thread_cpu_time;
+    int training_count = ceil(sweep->data_count * config->training_weight);
+    int test_count = sweep->data_count - training_count;
+    const ML_Data_Row *test_rows = &sweep->data_rows[training_count];
+    Predicted_Result *predicted_results = malloc(sizeof(Predicted_Result) * (test_count + 1));
+
+    if (!predicted_results)
+    {
+        printf("Error allocating memory for configuration %d\n", config_index);
+        exit(1);
+    }
+
+    // each configuration trains its own model so that the configurations do not share any state
+    double start_time = get_time();
+    double training_end_time = start_time;
+    switch (config->model)
+    {
+    case SWEEP_NAIVE_BAYES:
+    {
+        Naive_Bayes_Model *model = malloc(sizeof(Naive_Bayes_Model));
+        if (!model)
+        {
+            printf("Error allocating memory for configuration %d\n", config_index);
+            exit(1);
+        }
+
+        naive_bayes_reset(model);
+        model->smoothing = config->smoothing;
+        naive_bayes_count(model, sweep->data_rows, NULL, training_count);
+        naive_bayes_finalize(model);
+        training_end_time = get_time();
+
+        // the table costs a prediction of every board, so it only pays off for test sets with more rows than boards
+        if (test_count >= BOARD_STATE_COUNT)
+            naive_bayes_build_table(model);
+        for (int batch_start = 0; batch_start < test_count; batch_start += PREDICT_BATCH_SIZE)
+            naive_bayes_predict_rows(model, &test_rows[batch_start], fmin(PREDICT_BATCH_SIZE, test_count - batch_start), &predicted_results[batch_start]);
+        free(model);
+        break;
+    }
+    case SWEEP_KNN:
+    {
+        Knn_Model *model = malloc(sizeof(Knn_Model));
+        if (!model)
+        {
+            printf("Error allocating memory for configuration %d\n", config_index);
+            exit(1);
+        }
+
+        knn_train(model, sweep->data_rows, training_count);
+        training_end_time = get_time();
+
+        // the rows are packed and scored in batches of the size the game scores its candidate moves
+        for (int batch_start = 0; batch_start < test_count; batch_start += KNN_MAX_CANDIDATES)
+        {
+            unsigned int candidates[KNN_MAX_CANDIDATES];
+            int batch_count = fmin(KNN_MAX_CANDIDATES, test_count - batch_start);
+
+            for (int i = 0; i < batch_count; i++)
+                candidates[i] = pack_board(test_rows[batch_start + i].tile);
+            knn_predict_batch(model, candidates, batch_count, &predicted_results[batch_start]);
+        }
+        free(model);
+        break;
+    }
+    case SWEEP_MLP:
+    {
+        Mlp_Model model;
+
+        mlp_train(&model, sweep->data_rows, training_count, sweep->seed);
+        training_end_time = get_time();
+        mlp_predict_batch(&model, test_rows, test_count, predicted_results);
+        break;
+    }
+    case SWEEP_FOREST:
+    {
+        Random_Forest forest = {NULL};
+
+        train_random_forest(&forest, sweep->data_rows, training_count, sweep->seed);
+        training_end_time = get_time();
+        forest_predict_batch(&forest, test_rows, test_count, predicted_results);
+        free(forest.nodes);
+        break;
+    }
+    default:
+        break;
+    }
+    double end_time = get_time();
+
+    config->confusion_matrix = (Confusion_Matrix){0, 0, 0, 0, 0, 0};
+    for (int i = 0; i < test_count; i++)
+        add_to_confusion_matrix(&config->confusion_matrix, test_rows[i].result, predicted_results[i].result);
+    normalize_confusion_matrix(&config->confusion_matrix);
+
+    config->training_time = training_end_time - start_time;
+    config->inference_time = test_count > 0 ? (end_time - training_end_time) / test_count : 0;
+
+    free(predicted_results);
+}
+
+/*
+Runs every model with every training split, and naive bayes with every smoothing, on the same shuffled dataset
+The single threaded configurations are ran in parallel, one per core, and then the neural network and forest configurations
+are ran one after another, as they already train on every core with run_parallel as they do in the game
+The results are printed as csv to stdout and the summary to stderr, so that the output can be redirected into a csv file
+*/
+void run_sweep(unsigned int seed)
+{
+    const double training_weights[] = {0.5, 0.6, 0.7, 0.8, 0.9};
+    const double smoothings[] = {0, 0.5, 1, 2};
+    int training_weight_count = sizeof(training_weights) / sizeof(training_weights[0]);
+    int smoothing_count = sizeof(smoothings) / sizeof(smoothings[0]);
+    Sweep sweep = {gp_dataset_array, g_dataset_count, seed, NULL, 0, NULL};
+
+    sweep.configs = malloc(sizeof(Sweep_Config) * SWEEP_MODEL_COUNT * training_weight_count * smoothing_count);
+    sweep.config_indices = malloc(sizeof(int) * SWEEP_MODEL_COUNT * training_weight_count * smoothing_count);
+    if (!sweep.configs || !sweep.config_indices)
+    {
+        printf("Error allocating memory for the sweep\n");
+        exit(1);
+    }
+
+    // the smoothing only changes naive bayes, so the other models are ran once for every training split
+    for (int model = 0; model < SWEEP_MODEL_COUNT; model++)
+        for (int i = 0; i < training_weight_count; i++)
+            for (int j = 0; j < (model == SWEEP_NAIVE_BAYES ? smoothing_count : 1); j++)
+                sweep.configs[sweep.config_count++] = (Sweep_Config){model, training_weights[i], model == SWEEP_NAIVE_BAYES ? smoothings[j] : 0,
+                                                                     model == SWEEP_MLP || model == SWEEP_FOREST, {0, 0, 0, 0, 0, 0}, 0, 0};
+
+    // every configuration reads the same shuffled rows, so the splits only depend on the seed
+    Random random;
+    random_seed(&random, seed);
+    shuffle_dataset(&random);
+
+    // the single threaded configurations are listed first and ran as one parallel job, a nested run_parallel would run inline
+    int parallel_count = 0;
+    for (int i = 0; i < sweep.config_count; i++)
+        if (!sweep.configs[i].multithreaded)
+            sweep.config_indices[parallel_count++] = i;
+    int task_count = parallel_count;
+    for (int i = 0; i < sweep.config_count; i++)
+        if (sweep.configs[i].multithreaded)
+            sweep.config_indices[task_count++] = i;
+
+    double start_time = get_monotonic_time();
+    run_parallel(sweep_config_task, parallel_count, &sweep);
+    for (int task_index = parallel_count; task_index < task_count; task_index++)
+        sweep_config_task(task_index, &sweep);
+    double elapsed_time = get_monotonic_time() - start_time;
+
+    printf("model,training_weight,smoothing,accuracy,training_ms,inference_ns_per_row\n");
+    for (int i = 0; i < sweep.config_count; i++)
+    {
+        const Sweep_Config *config = &sweep.configs[i];
+        printf("%s,%.2f,%.2f,%f,%.3f,%.1f\n", SWEEP_MODEL_NAMES[config->model], config->training_weight, config->smoothing,
+               config->confusion_matrix.accuracy, config->training_time * 1e3, config->inference_time * 1e9);
+    }
+    fprintf(stderr, "seed %u, %d configurations in %.2fs, %d ran in parallel on %d threads\n", seed, sweep.config_count, elapsed_time, parallel_count, get_thread_count());
+
+    free(sweep.configs);
+    free(sweep.config_indices);
+}
+
+/*
+Returns a hash of the bitboard that is spread over all 64 bits
+*/
+unsigned long long hash_bitboard(Bitboard board)
+{
+    unsigned long long hash = board.cross * 0x9E3779B97F4A7C15ULL ^ board.circle * 0xC2B2AE3D27D4EB4FULL;
+
+    return hash ^ (hash >> 29);
+}
+
+/*
+Allocates an empty set with room for at least the given number of bitboards
+*/
+void bitboard_set_init(Bitboard_Set *set, size_t expected_count)
+{
+    set->capacity = 16;
+    while (set->capacity < expected_count * 2)
+        set->capacity *= 2;
+
+    set->count = 0;
+    set->slots = malloc(set->capacity * sizeof(Bitboard));
+    if (!set->slots)
+    {
+        printf("Error allocating memory for %lu bitboards\n", (unsigned long)set->capacity);
+        exit(1);
+    }
+
+    // a board with every bit set in both masks cannot exist, so it marks an empty slot
+    memset(set->slots, 0xFF, set->capacity * sizeof(Bitboard));
+}
+
+/*
+Frees the slots of the set
+*/
+void bitboard_set_free(Bitboard_Set *set)
+{
+    free(set->slots);
+    set->slots = NULL;
+    set->capacity = set->count = 0;
+}
+
+/*
+Adds the bitboard into the set using linear probing, returns true if it was not in the set yet
+The set doubles its capacity when it becomes half full
+*/
+bool bitboard_set_insert(Bitboard_Set *set, Bitboard board)
+{
+    // grow the set and insert the old bitboards again before it gets too full
+    if ((set->count + 1) * 2 > set->capacity)
+    {
+        Bitboard_Set grown_set;
+        bitboard_set_init(&grown_set, set->capacity);
+
+        for (size_t i = 0; i < set->capacity; i++)
+            if ((set->slots[i].cross & set->slots[i].circle) == 0)
+                bitboard_set_insert(&grown_set, set->slots[i]);
+
+        bitboard_set_free(set);
+        *set = grown_set;
+    }
+
+    size_t mask = set->capacity - 1;
+
+    for (size_t slot = hash_bitboard(board) & mask;; slot = (slot + 1) & mask)
+    {
+        Bitboard *current = &set->slots[slot];
+
+        // found an empty slot, the bitboard is not in the set
+        if ((current->cross & current->circle) != 0)
+        {
+            *current = board;
+            set->count++;
+            return true;
+        }
+        if (current->cross == board.cross && current->circle == board.circle)
+            return false;
+    }
+}
+
+/*
+Sets up the winning lines of a square board, every full row, column and both diagonals win like in the game
+The transposition table is allocated with 2^table_bits entries, or not at all if table_bits is 0
+*/
+void board_solver_init(Board_Solver *solver, int board_size, int table_bits)
+{
+    solver->size = board_size;
+    solver->cell_count = board_size * board_size;
+    solver->line_count = 0;
+
+    unsigned long long diagonal = 0, anti_diagonal = 0;
+    for (int i = 0; i < board_size; i++)
+    {
+        unsigned long long row = 0, column = 0;
+        for (int j = 0; j < board_size; j++)
+        {
+            row |= 1ULL << (i * board_size + j);
+            column |= 1ULL << (j * board_size + i);
+        }
+        solver->line_masks[solver->line_count++] = row;
+        solver->line_masks[solver->line_count++] = column;
+
+        diagonal |= 1ULL << (i * board_size + i);
+        anti_diagonal |= 1ULL << ((board_size - 1 - i) * board_size + i);
+    }
+    solver->line_masks[solver->line_count++] = diagonal;
+    solver->line_masks[solver->line_count++] = anti_diagonal;
+
+    solver->table_mask = (1ULL << table_bits) - 1;
+    solver->table = table_bits > 0 ? calloc(solver->table_mask + 1, sizeof(Solver_Entry)) : NULL;
+    if (!solver->table && table_bits > 0)
+    {
+        printf("Error allocating memory for the solver table\n");
+        exit(1);
+    }
+}
+
+/*
+Frees the transposition table of the solver
+*/
+void board_solver_free(Board_Solver *solver)
+{
+    free(solver->table);
+    solver->table = NULL;
+}
+
+/*
+Returns true if the tiles of one player fill any of the winning lines
+*/
+bool has_winning_line(const Board_Solver *solver, unsigned long long tiles)
+{
+    for (int i = 0; i < solver->line_count; i++)
+        if ((tiles & solver->line_masks[i]) == solver->line_masks[i])
+            return true;
+
+    return false;
+}
+
+/*
+Returns true if the game is over at this position, either a player has a line or the board is full
+*/
+bool is_position_over(const Board_Solver *solver, Bitboard board)
+{
+    return has_winning_line(solver, board.cross) || has_winning_line(solver, board.circle) ||
+           __builtin_popcountll(board.cross | board.circle) == solver->cell_count;
+}
+
+/*
+Negamax search with alpha-beta pruning and a transposition table that returns the exact result of the position
+The result is for the player to move, 1 for a win, 0 for a draw and -1 for a loss with perfect play from both players
+Cross always moves first, so it is cross to move when both players have the same number of tiles
+*/
+int solve_position(Board_Solver *solver, Bitboard board, int alpha, int beta)
+{
+    bool cross_to_move = __builtin_popcountll(board.cross) == __builtin_popcountll(board.circle);
+    unsigned long long occupied = board.cross | board.circle;
+
+    // the previous move won the game for the opponent
+    if (has_winning_line(solver, cross_to_move ? board.circle : board.cross))
+        return -1;
+    // the board is full without a winner
+    if (__builtin_popcountll(occupied) == solver->cell_count)
+        return 0;
+
+    // the player to move wins right away if a line only misses one empty cell
+    unsigned long long own = cross_to_move ? board.cross : board.circle;
+    for (int i = 0; i < solver->line_count; i++)
+    {
+        unsigned long long missing = solver->line_masks[i] & ~own;
+        if ((missing & (missing - 1)) == 0 && (missing & occupied) == 0)
+            return 1;
+    }
+
+    // use the stored result if this position has been searched before
+    Solver_Entry *entry = &solver->table[hash_bitboard(board) & solver->table_mask];
+    int original_alpha = alpha;
+    if (entry->bound != SOLVER_BOUND_NONE && entry->board.cross == board.cross && entry->board.circle == board.circle)
+    {
+        if (entry->bound == SOLVER_BOUND_EXACT)
+            return entry->value;
+        if (entry->bound == SOLVER_BOUND_LOWER && entry->value > alpha)
+            alpha = entry->value;
+        else if (entry->bound == SOLVER_BOUND_UPPER && entry->value < beta)
+            beta = entry->value;
+        if (alpha >= beta)
+            return entry->value;
+    }
+
+    int best_value = -1;
+    for (int cell = 0; cell < solver->cell_count; cell++)
+    {
+        unsigned long long cell_mask = 1ULL << cell;
+        if (occupied & cell_mask)
+            continue;
+
+        // place the tile of the player to move and search the position from the opponent's side
+        Bitboard child = board;
+        if (cross_to_move)
+            child.cross |= cell_mask;
+        else
+            child.circle |= cell_mask;
+
+        int value = -solve_position(solver, child, -beta, -alpha);
+        if (value > best_value)
+            best_value = value;
+        if (best_value > alpha)
+            alpha = best_value;
+        // a win cannot be improved on, and the opponent will avoid this position if it is better than beta
+        if (alpha >= beta)
+            break;
+    }
+
+    // store whether the value is exact or only a bound because of the alpha-beta window
+    entry->board = board;
+    entry->value = best_value;
+    entry->bound = best_value <= original_alpha ? SOLVER_BOUND_UPPER : best_value >= beta ? SOLVER_BOUND_LOWER : SOLVER_BOUND_EXACT;
+
+    return best_value;
+}
+
+/*
+Solves the position and adds it to the positions of the task, labeled positive if cross wins with perfect play
+*/
+void add_labeled_position(Generator_Task *task, Board_Solver *solver, Bitboard board)
+{
+    int value = solve_position(solver, board, -1, 1);
+    bool cross_to_move = __builtin_popcountll(board.cross) == __builtin_popcountll(board.circle);
+
+    // grow the per task buffer, each task has its own so no locking is needed
+    if (task->position_count == task->position_capacity)
+    {
+        task->position_capacity = task->position_capacity == 0 ? 1024 : task->position_capacity * 2;
+        task->positions = realloc(task->positions, task->position_capacity * sizeof(Labeled_Position));
+        if (!task->positions)
+        {
+            printf("Error allocating memory for generated positions\n");
+            exit(1);
+        }
+    }
+
+    // value is for the player to move, turn it into the result for cross
+    task->positions[task->position_count].board = board;
+    task->positions[task->position_count].result = (cross_to_move ? value : -value) == 1 ? POSITIVE : NEGATIVE;
+    task->position_count++;
+}
+
+/*
+Visits every position that can be reached from the board in a real game, skipping positions that were already visited
+*/
+void enumerate_positions(Generator_Task *task, Board_Solver *solver, Bitboard board)
+{
+    if (!bitboard_set_insert(&task->seen, board))
+        return;
+
+    add_labeled_position(task, solver, board);
+
+    // no more moves can be played once the game is over
+    if (is_position_over(solver, board))
+        return;
+
+    bool cross_to_move = __builtin_popcountll(board.cross) == __builtin_popcountll(board.circle);
+    for (int cell = 0; cell < solver->cell_count; cell++)
+    {
+        unsigned long long cell_mask = 1ULL << cell;
+        if ((board.cross | board.circle) & cell_mask)
+            continue;
+
+        Bitboard child = board;
+        if (cross_to_move)
+            child.cross |= cell_mask;
+        else
+            child.circle |= cell_mask;
+        enumerate_positions(task, solver, child);
+    }
+}
+
+/*
+Runs one task of the dataset generator, ran by the worker threads of run_parallel
+When enumerating, each task visits every position after cross plays its first move on cell task_index
+When sampling, each task plays random games that stop after a random number of moves and keeps the position it stopped at
+*/
+void generate_dataset_task(int task_index, void *context)
+{
+    Dataset_Generator *generator = context;
+    Generator_Task *task = &generator->tasks[task_index];
+
+    // claim a solver that no other task is using, there are never more running tasks than solvers
+    int solver_index = 0;
+    while (__atomic_exchange_n(&generator->solver_in_use[solver_index], 1, __ATOMIC_ACQUIRE))
+        solver_index++;
+
+    Board_Solver *solver = &generator->solvers[solver_index];
+    if (!solver->table)
+        board_solver_init(solver, generator->board_size, SOLVER_TABLE_BITS);
+
+    if (generator->sample_count == 0)
+    {
+        Bitboard board = {0, 0};
+
+        bitboard_set_init(&task->seen, 1024);
+        // the empty board is only added by the first task
+        if (task_index == 0)
+            enumerate_positions(task, solver, board);
+        board.cross = 1ULL << task_index;
+        enumerate_positions(task, solver, board);
+    }
+    else
+    {
+        // split the samples evenly and give each task its own random sequence so the output only depends on the seed
+        int sample_count = generator->sample_count / GENERATOR_TASK_COUNT + (task_index < generator->sample_count % GENERATOR_TASK_COUNT);
+        Random random;
+        random_seed(&random, generator->seed + task_index * 0x632BE59BD9B4E019ULL);
+
+        bitboard_set_init(&task->seen, sample_count);
+        for (int sample = 0; sample < sample_count; sample++)
+        {
+            Bitboard board = {0, 0};
+            int move_count = random_below(&random, solver->cell_count + 1);
+
+            for (int move = 0; move < move_count && !is_position_over(solver, board); move++)
+            {
+                // pick a random empty cell and place the tile of the player to move
+                unsigned long long occupied = board.cross | board.circle;
+                int empty_index = random_below(&random, solver->cell_count - __builtin_popcountll(occupied));
+                int cell = 0;
+                while (occupied & (1ULL << cell) || empty_index-- > 0)
+                    cell++;
+
+                if (move % 2 == 0)
+                    board.cross |= 1ULL << cell;
+                else
+                    board.circle |= 1ULL << cell;
+            }
+
+            if (bitboard_set_insert(&task->seen, board))
+                add_labeled_position(task, solver, board);
+        }
+    }
+
+    bitboard_set_free(&task->seen);
+    __atomic_store_n(&generator->solver_in_use[solver_index], 0, __ATOMIC_RELEASE);
+}
+
+/*
+Generates a dataset of positions labeled by the solver and writes it in the format of the UCI dataset, with one cell per square of the board
+Only 3x3 datasets can be read back by read_ml_dataset, larger boards are written for other programs
+A sample count of 0 enumerates every reachable position, which is only practical for 3x3 boards
+Positions are generated in parallel into per task buffers, then duplicates are removed while writing the file
+*/
+void run_dataset_generator(int board_size, char file_name[], int sample_count, unsigned long long seed)
+{
+    static Dataset_Generator generator;
+    int task_count = sample_count == 0 ? board_size * board_size : GENERATOR_TASK_COUNT;
+
+    if (board_size < 3 || board_size > GENERATOR_MAX_BOARD_SIZE)
+    {
+        printf("Board size must be between 3 and %d\n", GENERATOR_MAX_BOARD_SIZE);
+        exit(1);
+    }
+
+    FILE *dataset_file = fopen(file_name, "w");
+    if (!dataset_file)
+    {
+        printf("Error opening file %s\n", file_name);
+        exit(1);
+    }
+
+    double start_time = get_monotonic_time();
+
+    memset(&generator, 0, sizeof(generator));
+    generator.board_size = board_size;
+    generator.sample_count = sample_count;
+    generator.seed = seed;
+    run_parallel(generate_dataset_task, task_count, &generator);
+
+    double generate_time = get_monotonic_time() - start_time;
+
+    // merge the buffers of the tasks in order, skipping positions that another task already generated
+    Bitboard_Set written;
+    int generated_count = 0, positive_count = 0;
+    char line[GENERATOR_MAX_BOARD_SIZE * GENERATOR_MAX_BOARD_SIZE * 2 + 16];
+
+    bitboard_set_init(&written, 1024);
+    for (int task_index = 0; task_index < task_count; task_index++)
+    {
+        Generator_Task *task = &generator.tasks[task_index];
+        generated_count += task->position_count;
+
+        for (int i = 0; i < task->position_count; i++)
+        {
+            Labeled_Position *position = &task->positions[i];
+            if (!bitboard_set_insert(&written, position->board))
+                continue;
+
+            // write each cell as x, o or b followed by a comma, then the result
+            int length = 0;
+            for (int cell = 0; cell < board_size * board_size; cell++)
+            {
+                unsigned long long cell_mask = 1ULL << cell;
+                line[length++] = position->board.cross & cell_mask ? 'x' : position->board.circle & cell_mask ? 'o' : 'b';
+                line[length++] = ',';
+            }
+            strcpy(&line[length], position->result == POSITIVE ? "positive\n" : "negative\n");
+            fputs(line, dataset_file);
+
+            positive_count += position->result == POSITIVE;
+        }
+
+        free(task->positions);
+    }
+
+    fclose(dataset_file);
+    for (int i = 0; i < MAX_THREAD_COUNT; i++)
+        board_solver_free(&generator.solvers[i]);
+
+    printf("%dx%d board, %d positions generated, %d unique (%d positive) written to %s\n", board_size, board_size, generated_count, (int)written.count, positive_count, file_name);
+    printf("generated in %.3f seconds on %d threads, %.0f positions per second\n", generate_time, get_thread_count(), generated_count / generate_time);
+
+    bitboard_set_free(&written);
+}
+
+/*
+Returns true if the 9 bit mask of a player's tiles fills any row, column or diagonal of the 3x3 board
+*/
+bool is_winning_mask(unsigned int tiles)
+{
+    for (int i = 0; i < 8; i++)
+        if ((tiles & WINNING_MASKS[i]) == WINNING_MASKS[i])
+            return true;
+
+    return false;
+}
+
+/*
+Sets the starting value of every board, 1 if cross has won, -1 if circle has won and 0 otherwise
+The finished boards are never updated, so they act as the rewards of the game
+*/
+void td_init_values(float values[])
+{
+    for (int board_index = 0; board_index < BOARD_STATE_COUNT; board_index++)
+    {
+        unsigned int tiles[3] = {0, 0, 0};
+
+        for (int i = 0, digits = board_index; i < 9; i++, digits /= 3)
+            tiles[digits % 3] |= 1u << i;
+
+        if (is_winning_mask(tiles[CROSS]))
+            values[board_index] = 1;
+        else if (is_winning_mask(tiles[CIRCLE]))
+            values[board_index] = -1;
+        else
+            values[board_index] = 0;
+    }
+}
+
+/*
+Plays a number of self play games on a copy of the values and learns from every greedy move with TD(0)
+The value of the board after a move is moved towards the value of the board after the next move
+Cross picks the board with the highest value and circle the lowest, with random moves to keep exploring
+*/
+void td_self_play_task(int task_index, void *context)
+{
+    Td_Training *training = context;
+    float *values = training->task_values + (size_t)task_index * BOARD_STATE_COUNT;
+    Random random;
+
+    // every task of every round has its own random sequence, so the training only depends on the seed
+    random_seed(&random, training->seed + (unsigned long long)training->round * TD_TASK_COUNT + task_index);
+    memcpy(values, training->values, sizeof(float) * BOARD_STATE_COUNT);
+
+    for (int game = 0; game < training->game_count; game++)
+    {
+        unsigned int tiles[3] = {0, 0, 0};
+        int board_index = 0, previous_index = -1;
+        Tile tile = CROSS;
+
+        for (int turn = 0; turn < 9; turn++)
+        {
+            unsigned int empty = ~(tiles[CROSS] | tiles[CIRCLE]) & 0x1FF;
+            float sign = tile == CROSS ? 1 : -1;
+            int cell = -1;
+            bool exploratory = random_float(&random) < TD_EXPLORATION_RATE;
+
+            if (exploratory)
+            {
+                // pick a random empty cell by skipping a random number of the empty cells
+                int skip = random_below(&random, __builtin_popcount(empty));
+                unsigned int remaining = empty;
+                while (skip-- > 0)
+                    remaining &= remaining - 1;
+                cell = __builtin_ctz(remaining);
+            }
+            else
+            {
+                // pick the empty cell that leads to the best board for the current player
+                float best_value = -INFINITY;
+                for (unsigned int remaining = empty; remaining != 0; remaining &= remaining - 1)
+                {
+                    int candidate = __builtin_ctz(remaining);
+                    float value = sign * values[board_index + tile * CELL_WEIGHT[candidate]];
+                    if (value > best_value)
+                    {
+                        best_value = value;
+                        cell = candidate;
+                    }
+                }
+            }
+
+            board_index += tile * CELL_WEIGHT[cell];
+            tiles[tile] |= 1u << cell;
+
+            // learn from greedy moves only, a random move says nothing about the value of the previous board
+            if (!exploratory && previous_index >= 0)
+                values[previous_index] += TD_LEARNING_RATE * (values[board_index] - values[previous_index]);
+            previous_index = board_index;
+
+            if (is_winning_mask(tiles[tile]))
+                break;
+
+            tile = tile == CROSS ? CIRCLE : CROSS;
+        }
+    }
+}
+
+/*
+Trains the values with game_count self play games
+The games are played in rounds, every task of a round learns on its own copy of the values and the copies are averaged after the round
+*/
+void td_train(float values[], int game_count, unsigned long long seed)
+{
+    Td_Training training = {values, NULL, TD_ROUND_GAMES, seed, 0};
+
+    training.task_values = malloc(sizeof(float) * BOARD_STATE_COUNT * TD_TASK_COUNT);
+    if (training.task_values == NULL)
+    {
+        printf("Failed to allocate memory for the TD training\n");
+        exit(1);
+    }
+
+    td_init_values(values);
+
+    int round_count = (game_count + TD_TASK_COUNT * TD_ROUND_GAMES - 1) / (TD_TASK_COUNT * TD_ROUND_GAMES);
+    for (training.round = 0; training.round < round_count; training.round++)
+    {
+        run_parallel(td_self_play_task, TD_TASK_COUNT, &training);
+
+        for (int board_index = 0; board_index < BOARD_STATE_COUNT; board_index++)
+        {
+            float sum = 0;
+            for (int task = 0; task < TD_TASK_COUNT; task++)
+                sum += training.task_values[(size_t)task * BOARD_STATE_COUNT + board_index];
+            values[board_index] = sum / TD_TASK_COUNT;
+        }
+    }
+
+    free(training.task_values);
+}
+
+/*
+Quantizes the values between -1 and 1 into shorts, which halves the size of the table
+*/
+void td_quantize_values(const float values[], short quantized_values[])
+{
+    for (int board_index = 0; board_index < BOARD_STATE_COUNT; board_index++)
+    {
+        float value = fmaxf(-1, fminf(1, values[board_index]));
+        quantized_values[board_index] = (short)lrintf(value * TD_VALUE_SCALE);
+    }
+}
+
+/*
+Headless trainer for the TD table, trains with game_count self play games and saves the table into the file
+*/
+void run_td_training(int game_count, char file_name[], unsigned long long seed)
+{
+    static float values[BOARD_STATE_COUNT];
+    static short quantized_values[BOARD_STATE_COUNT];
+
+    if (game_count <= 0)
+    {
+        printf("Number of games must be positive\n");
+        exit(1);
+    }
+
+    double start_time = get_monotonic_time();
+    td_train(values, game_count, seed);
+    double elapsed_time = get_monotonic_time() - start_time;
+    td_quantize_values(values, quantized_values);
+
+    FILE *file = fopen(file_name, "wb");
+    if (file == NULL)
+    {
+        printf("Failed to open file: %s\n", file_name);
+        exit(1);
+    }
+
+    // the number of games is rounded up to whole rounds
+    int round_games = TD_TASK_COUNT * TD_ROUND_GAMES;
+    Td_Table_Header header = {TD_TABLE_MAGIC, TD_TABLE_VERSION, BOARD_STATE_COUNT, (game_count + round_games - 1) / round_games * round_games};
+    fwrite(&header, sizeof(header), 1, file);
+    fwrite(quantized_values, sizeof(short), BOARD_STATE_COUNT, file);
+    fclose(file);
+
+    printf("%d self play games in %.2f s (%.0f games/s) using %d threads, saved to %s\n",
+           header.game_count, elapsed_time, header.game_count / elapsed_time, get_thread_count(), file_name);
+}
+
+/*
+Maps the TD table file into memory so that the game can look up values without reading the whole file
+Returns false if the file is missing or invalid, the values are then trained by the startup loader
+*/
+bool load_td_table(char file_name[])
+{
+    size_t file_size = sizeof(Td_Table_Header) + sizeof(short) * BOARD_STATE_COUNT;
+    const Td_Table_Header *header = NULL;
+    int packed_size = 0;
+    const unsigned char *packed_data = find_packed_resource(file_name, &packed_size);
+
+    // the packed table is aligned and kept until the program exits, so the values are used in place
+    if (packed_data != NULL)
+    {
+        if ((size_t)packed_size == file_size)
+            header = (const Td_Table_Header *)packed_data;
+    }
+    else
+    {
+#if defined(_WIN32)
+        // no mmap on windows, so the file is read into memory instead
+        FILE *file = fopen(file_name, "rb");
+        if (file == NULL)
+            return false;
+
+        void *data = malloc(file_size);
+        if (data != NULL && fread(data, 1, file_size, file) == file_size && fgetc(file) == EOF)
+            header = data;
+        else
+            free(data);
+        fclose(file);
+#else
+        int file_descriptor = open(file_name, O_RDONLY);
+        if (file_descriptor < 0)
+            return false;
+
+        // the mapping stays valid after the file is closed and is kept until the program exits
+        struct stat file_stat;
+        if (fstat(file_descriptor, &file_stat) == 0 && (size_t)file_stat.st_size == file_size)
+        {
+            void *data = mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+            if (data != MAP_FAILED)
+                header = data;
+        }
+        close(file_descriptor);
+#endif
+    }
+
+    if (header == NULL || memcmp(header->magic, TD_TABLE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != TD_TABLE_VERSION || header->count != BOARD_STATE_COUNT)
+    {
+        printf("Invalid TD table file: %s\n", file_name);
+        return false;
+    }
+
+    gp_td_values = (const short *)(header + 1);
+    return true;
+}
+
+/*
+Returns the best move from the TD values, the move that leads to the board with the best value for the AI
+*/
+Move get_td_best_move()
+{
+    int board_index = 0;
+    for (int i = 0; i < ROW; i++)
+        for (int j = 0; j < COLUMN; j++)
+            board_index += g_grid[i][j] * CELL_WEIGHT[i * 3 + j];
+
+    int sign = g_player_two.tile == CROSS ? 1 : -1;
+    int best_value = INT_MIN;
+    Move best_move = {-1, -1};
+
+    for (int i = 0; i < ROW; i++)
         for (int j = 0; j < COLUMN; j++)
-        {
             if (g_grid[i][j] == EMPTY)
             {
-                return 0;
+                int value = sign * gp_td_values[board_index + g_player_two.tile * CELL_WEIGHT[i * 3 + j]];
+                if (value > best_value)
+                {
+                    best_value = value;
+                    best_move = (Move){i, j};
+                }
+            }
+
+    return best_move;
+}
+
+/*
+Trains the TD values in memory if the TD table file was not loaded, called by the startup loader after the table is loaded
+*/
+void prepare_td_values()
+{
+    if (gp_td_values == NULL)
+    {
+        static float values[BOARD_STATE_COUNT];
+        td_train(values, TD_FALLBACK_GAMES, 0);
+        td_quantize_values(values, g_td_fallback_values);
+        gp_td_values = g_td_fallback_values;
+    }
+}
+
+/*
+Builds the texture atlas of the spectator view, the cross and circle of the tile texture next to a block of white pixels
+Shapes are drawn with the white block, so every board of the view is drawn with one texture in one batch
+*/
+void load_spectator_atlas()
+{
+    Image tile_image = load_packed_image(TEXTURE_FILE_PATH);
+    Image atlas_image = GenImageColor(SPECTATOR_ATLAS_WIDTH, SPECTATOR_ATLAS_HEIGHT, BLANK);
+
+    ImageDraw(&atlas_image, tile_image, SPECTATOR_CROSS_SOURCE, SPECTATOR_CROSS_SOURCE, WHITE);
+    ImageDraw(&atlas_image, tile_image, SPECTATOR_CIRCLE_SOURCE, SPECTATOR_CIRCLE_SOURCE, WHITE);
+    ImageDrawRectangle(&atlas_image, SPECTATOR_WHITE_SOURCE.x - 2, SPECTATOR_WHITE_SOURCE.y - 2, SPECTATOR_WHITE_SOURCE.width + 4, SPECTATOR_WHITE_SOURCE.height + 4, WHITE);
+
+    g_spectator_atlas = LoadTextureFromImage(atlas_image);
+    UnloadImage(tile_image);
+    UnloadImage(atlas_image);
+}
+
+/*
+Clears a spectator game and schedules its first move after a random delay, so that the games do not move at the same time
+*/
+void reset_spectator_game(Spectator_Game *game, unsigned long long now_ns)
+{
+    memset(game->tile, EMPTY, sizeof(game->tile));
+    game->turn = CROSS;
+    game->winner = EMPTY;
+    game->finished = false;
+    game->next_event_ns = now_ns + random_below(&g_spectator_random, 2 * SPECTATOR_MOVE_INTERVAL_NS);
+}
+
+/*
+Starts a new game on every board of the spectator view
+*/
+void start_spectating()
+{
+    // the TD values are loaded or trained by the startup loader
+    wait_for_startup_loader();
+    if (g_spectator_atlas.id == 0)
+        TRACE_CALL("load_spectator_atlas", load_spectator_atlas());
+
+    random_seed(&g_spectator_random, time(NULL));
+    unsigned long long now_ns = get_monotonic_ns();
+    for (int i = 0; i < SPECTATOR_GAME_COUNT; i++)
+        reset_spectator_game(&g_spectator_games[i], now_ns);
+    memset(g_spectator_results, 0, sizeof(g_spectator_results));
+}
+
+/*
+Plays one move of a spectator game, the best move from the TD values for the player whose turn it is
+With a chance of SPECTATOR_EXPLORATION_RATE a random move is played instead, so that the games are not all the same
+*/
+void play_spectator_move(Spectator_Game *game)
+{
+    int board_index = encode_board(game->tile);
+    int sign = game->turn == CROSS ? 1 : -1;
+    int empty_cells[9], empty_count = 0, best_cell = -1, best_value = INT_MIN;
+
+    for (int i = 0; i < 9; i++)
+        if (game->tile[i] == EMPTY)
+        {
+            empty_cells[empty_count++] = i;
+            int value = sign * gp_td_values[board_index + game->turn * CELL_WEIGHT[i]];
+            if (value > best_value)
+            {
+                best_value = value;
+                best_cell = i;
             }
         }
+
+    if (random_float(&g_spectator_random) < SPECTATOR_EXPLORATION_RATE)
+        best_cell = empty_cells[random_below(&g_spectator_random, empty_count)];
+    game->tile[best_cell] = game->turn;
+
+    // check if the move won the game or filled the board
+    unsigned int tiles = 0;
+    for (int i = 0; i < 9; i++)
+        if (game->tile[i] == game->turn)
+            tiles |= 1u << i;
+
+    if (is_winning_mask(tiles))
+        game->winner = game->turn;
+    game->finished = game->winner != EMPTY || empty_count == 1;
+    game->turn = game->turn == CROSS ? CIRCLE : CROSS;
+}
+
+/*
+Advances every spectator game whose next move is due, finished games are shown for a while and then restarted
+*/
+void step_spectator_games()
+{
+    unsigned long long now_ns = get_monotonic_ns();
+
+    for (int i = 0; i < SPECTATOR_GAME_COUNT; i++)
+    {
+        Spectator_Game *game = &g_spectator_games[i];
+        if (now_ns < game->next_event_ns)
+            continue;
+
+        if (game->finished)
+        {
+            reset_spectator_game(game, now_ns);
+            continue;
+        }
+
+        play_spectator_move(game);
+        if (game->finished)
+        {
+            g_spectator_results[game->winner]++;
+            game->next_event_ns = now_ns + SPECTATOR_RESULT_DELAY_NS;
+        }
+        else
+            game->next_event_ns = now_ns + SPECTATOR_MOVE_INTERVAL_NS / 2 + random_below(&g_spectator_random, SPECTATOR_MOVE_INTERVAL_NS);
+    }
+}
+
+/*
+Draws every spectator game as a mini board, below the text ui
+Rectangles are drawn with the white block of the atlas and tiles with the cross and circle of the atlas
+As every quad uses the same texture and draw mode, raylib does not need to flush the batch between boards
+*/
+void render_spectator_games()
+{
+    const float board_size = (float)SCREEN_WIDTH / SPECTATOR_COLUMNS;
+    const float cell_size = (board_size - SPECTATOR_BOARD_MARGIN) / 3;
+
+    SetShapesTexture(g_spectator_atlas, SPECTATOR_WHITE_SOURCE);
+    for (int i = 0; i < SPECTATOR_GAME_COUNT; i++)
+    {
+        const Spectator_Game *game = &g_spectator_games[i];
+        float x = (i % SPECTATOR_COLUMNS) * board_size;
+        float y = (i / SPECTATOR_COLUMNS) * board_size + UI_OFFSET;
+
+        // tint finished boards by their result, red for cross, blue for circle and grey for a draw
+        if (game->finished)
+        {
+            Color result_colour = game->winner == CROSS ? (Color){255, 0, 0, 60} : game->winner == CIRCLE ? (Color){0, 0, 255, 60} : (Color){0, 0, 0, 30};
+            DrawRectangleRec((Rectangle){x, y, cell_size * 3, cell_size * 3}, result_colour);
+        }
+
+        // the 2 lines between the columns and the rows
+        for (int line = 1; line < 3; line++)
+        {
+            DrawRectangleRec((Rectangle){x + line * cell_size, y, 1, cell_size * 3}, TITLE_COLOUR);
+            DrawRectangleRec((Rectangle){x, y + line * cell_size, cell_size * 3, 1}, TITLE_COLOUR);
+        }
+
+        for (int cell = 0; cell < 9; cell++)
+        {
+            if (game->tile[cell] == EMPTY)
+                continue;
+
+            Rectangle destination = {x + (cell % 3) * cell_size, y + (cell / 3) * cell_size, cell_size, cell_size};
+            DrawTexturePro(g_spectator_atlas, game->tile[cell] == CROSS ? SPECTATOR_CROSS_SOURCE : SPECTATOR_CIRCLE_SOURCE, destination, (Vector2){0, 0}, 0, WHITE);
+        }
+    }
+
+    // shapes outside of the view use raylib's default white texture again
+    SetShapesTexture((Texture2D){rlGetTextureIdDefault(), 1, 1, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8}, (Rectangle){0, 0, 1, 1});
+}
+
+/*
+Update loop for the spectator view, AI against AI games that restart when they finish
+*/
+void update_spectator()
+{
+    // if the escape button is pressed, return back to main menu
+    if (IsKeyReleased(KEY_ESCAPE))
+    {
+        set_current_state(MENU);
+        return;
+    }
+
+    step_spectator_games();
+
+    BeginDrawing();
+    ClearBackground(BACKGROUND_COLOUR);
+
+    // draw the results of the finished games in the text ui
+    const char *results_text = TextFormat("X wins %d   O wins %d   Draws %d", g_spectator_results[CROSS], g_spectator_results[CIRCLE], g_spectator_results[EMPTY]);
+    DrawText(results_text, SCREEN_WIDTH / 2 - MeasureText(results_text, 30) / 2, UI_OFFSET / 4, 30, TITLE_COLOUR);
+    render_spectator_games();
+
+    TRACE_CALL("EndDrawing", EndDrawing());
+}
+
+/*
+Clears the replay of the current game and records the settings it is played with, called when a game is started
+*/
+void start_replay()
+{
+    g_replay = (Replay){{g_session_seed, g_current_gamemode, g_game_difficulty_mode, 0, 0}, {0}};
+}
+
+/*
+Adds a move of the current game to its replay
+*/
+void record_replay_move(int row, int col)
+{
+    if (g_replay.header.move_count < REPLAY_MAX_MOVES)
+        g_replay.moves[g_replay.header.move_count++] = row * COLUMN + col;
+}
+
+/*
+Appends the replay of the finished game to REPLAY_FILE, the file is kept open so that each game is a single write
+The game keeps running without saving replays if the file cannot be opened
+*/
+void save_replay()
+{
+    if (gp_replay_file == NULL)
+    {
+        gp_replay_file = fopen(REPLAY_FILE, "ab");
+        if (gp_replay_file == NULL)
+        {
+            printf("Error opening replay file %s\n", REPLAY_FILE);
+            return;
+        }
+
+        // a new file starts with the file header, the replays are then appended to it
+        fseek(gp_replay_file, 0, SEEK_END);
+        if (ftell(gp_replay_file) == 0)
+        {
+            Replay_File_Header file_header = {REPLAY_MAGIC, REPLAY_VERSION};
+            fwrite(&file_header, sizeof(file_header), 1, gp_replay_file);
+        }
+    }
+
+    fwrite(&g_replay, sizeof(Replay_Header) + g_replay.header.move_count, 1, gp_replay_file);
+    // flush every game so that the viewer can read it and it is kept if the game crashes
+    fflush(gp_replay_file);
+}
+
+/*
+Returns the board after the first ply moves of a replay, cross always moves first
+*/
+Bitboard replay_to_ply(const unsigned char moves[], int ply)
+{
+    Bitboard board = {0, 0};
+
+    for (int i = 0; i < ply; i++)
+        if (i % 2 == 0)
+            board.cross |= 1ULL << moves[i];
+        else
+            board.circle |= 1ULL << moves[i];
+
+    return board;
+}
+
+/*
+Returns the tile that has won on a 3x3 bitboard, or EMPTY if neither has won
+*/
+Tile get_bitboard_winner(Bitboard board)
+{
+    if (is_winning_mask(board.cross))
+        return CROSS;
+    if (is_winning_mask(board.circle))
+        return CIRCLE;
+
+    return EMPTY;
+}
+
+/*
+Reads the replay that starts at offset of a replay file, and returns the offset of the next replay
+Returns 0 if the replay is cut off or invalid
+*/
+size_t read_replay(const unsigned char *data, size_t size, size_t offset, Replay_Header *header, const unsigned char **moves)
+{
+    if (offset + sizeof(Replay_Header) > size)
+        return 0;
+
+    memcpy(header, data + offset, sizeof(Replay_Header));
+    *moves = data + offset + sizeof(Replay_Header);
+    size_t next_offset = offset + sizeof(Replay_Header) + header->move_count;
+
+    if (header->move_count > REPLAY_MAX_MOVES || header->gamemode >= REPLAY_GAMEMODE_COUNT || next_offset > size)
+        return 0;
+
+    // every move has to be on an empty cell, so that the replay can be played back
+    unsigned int used_cells = 0;
+    for (int i = 0; i < header->move_count; i++)
+    {
+        if ((*moves)[i] >= ROW * COLUMN || (used_cells & (1 << (*moves)[i])) != 0)
+            return 0;
+        used_cells |= 1 << (*moves)[i];
+    }
+
+    return next_offset;
+}
+
+/*
+Reads a replay file and finds the offset of every replay in it, so that the viewer can go to any replay
+Returns false if the file is missing or is not a replay file, the replays before an invalid replay are kept
+*/
+bool load_replay_archive(Replay_Archive *archive, char file_name[])
+{
+    size_t size = 0;
+    archive->data = read_whole_file(file_name, &size);
+    archive->offsets = NULL;
+    archive->count = 0;
+
+    const Replay_File_Header *file_header = (const Replay_File_Header *)archive->data;
+    if (archive->data == NULL || size < sizeof(Replay_File_Header) ||
+        memcmp(file_header->magic, REPLAY_MAGIC, sizeof(file_header->magic)) != 0 || file_header->version != REPLAY_VERSION)
+    {
+        free(archive->data);
+        archive->data = NULL;
+        return false;
+    }
+
+    // every replay takes at least a header, so this is enough offsets for the whole file
+    archive->offsets = malloc((size / sizeof(Replay_Header) + 1) * sizeof(size_t));
+    if (archive->offsets == NULL)
+    {
+        printf("Error allocating memory for the replays of %s\n", file_name);
+        exit(1);
+    }
+
+    Replay_Header header;
+    const unsigned char *moves;
+    size_t offset = sizeof(Replay_File_Header);
+    while (offset < size)
+    {
+        size_t next_offset = read_replay(archive->data, size, offset, &header, &moves);
+        if (next_offset == 0)
+        {
+            printf("Invalid replay at offset %zu of %s\n", offset, file_name);
+            break;
+        }
+        archive->offsets[archive->count++] = offset;
+        offset = next_offset;
+    }
+
+    return true;
+}
+
+/*
+Frees the replays of a replay archive
+*/
+void free_replay_archive(Replay_Archive *archive)
+{
+    free(archive->data);
+    free(archive->offsets);
+    *archive = (Replay_Archive){NULL, NULL, 0};
+}
+
+/*
+Returns the header and the moves of a replay of the archive
+*/
+Replay_Header get_archived_replay(const Replay_Archive *archive, int index, const unsigned char **moves)
+{
+    Replay_Header header;
+    memcpy(&header, archive->data + archive->offsets[index], sizeof(Replay_Header));
+    *moves = archive->data + archive->offsets[index] + sizeof(Replay_Header);
+    return header;
+}
+
+/*
+Opens the replay viewer at the last move of the newest replay, which is the game that has just finished
+*/
+void open_replay_viewer()
+{
+    free_replay_archive(&g_replay_archive);
+    load_replay_archive(&g_replay_archive, REPLAY_FILE);
+    seek_replay(g_replay_archive.count - 1, REPLAY_MAX_MOVES);
+}
+
+/*
+Shows a move of a replay in the viewer, the board is rebuilt from the moves so any move can be shown instantly
+The replay and the ply are clamped to the ones that exist
+*/
+void seek_replay(int index, int ply)
+{
+    if (g_replay_archive.count == 0)
+        return;
+
+    g_replay_index = Clamp(index, 0, g_replay_archive.count - 1);
+
+    const unsigned char *moves;
+    Replay_Header header = get_archived_replay(&g_replay_archive, g_replay_index, &moves);
+    g_replay_ply = Clamp(ply, 0, header.move_count);
+    g_replay_board = replay_to_ply(moves, g_replay_ply);
+}
+
+/*
+Update loop of the replay viewer
+Up and down go to the previous and next replay, left and right step through the moves and the slider seeks to any move
+*/
+void update_replay_viewer()
+{
+    // if the escape button is pressed, return back to the game over screen
+    if (IsKeyReleased(KEY_ESCAPE))
+    {
+        set_current_state(GAMEOVER);
+        return;
+    }
+
+    if (IsKeyPressed(KEY_UP))
+        seek_replay(g_replay_index - 1, REPLAY_MAX_MOVES);
+    if (IsKeyPressed(KEY_DOWN))
+        seek_replay(g_replay_index + 1, REPLAY_MAX_MOVES);
+    if (IsKeyPressed(KEY_LEFT))
+        seek_replay(g_replay_index, g_replay_ply - 1);
+    if (IsKeyPressed(KEY_RIGHT))
+        seek_replay(g_replay_index, g_replay_ply + 1);
+    if (IsKeyPressed(KEY_HOME))
+        seek_replay(g_replay_index, 0);
+    if (IsKeyPressed(KEY_END))
+        seek_replay(g_replay_index, REPLAY_MAX_MOVES);
+
+    BeginDrawing();
+    ClearBackground(BACKGROUND_COLOUR);
+
+    if (g_replay_archive.count == 0)
+    {
+        const char *empty_text = TextFormat("No replays in %s", REPLAY_FILE);
+        DrawText(empty_text, SCREEN_WIDTH / 2 - MeasureText(empty_text, 30) / 2, UI_OFFSET / 4, 30, TITLE_COLOUR);
+        TRACE_CALL("EndDrawing", EndDrawing());
+        return;
+    }
+
+    const unsigned char *moves;
+    Replay_Header header = get_archived_replay(&g_replay_archive, g_replay_index, &moves);
+
+    // draw which replay is shown and how it ended
+    Tile winner = get_bitboard_winner(replay_to_ply(moves, header.move_count));
+    const char *result_text = winner == CROSS ? "X wins" : winner == CIRCLE ? "O wins" : header.move_count == REPLAY_MAX_MOVES ? "Draw" : "Unfinished";
+    const char *title_text = TextFormat("Game %d/%d   %s%s   %s", g_replay_index + 1, g_replay_archive.count, GAMEMODE_NAMES[header.gamemode],
+                                        header.gamemode == AI_MINIMAX ? TextFormat(" (%s)", DIFFICULTY_NAMES[header.difficulty % 3]) : "", result_text);
+    DrawText(title_text, SCREEN_WIDTH / 2 - MeasureText(title_text, 20) / 2, 6, 20, TITLE_COLOUR);
+
+    // the slider seeks to any move of the replay
+    float slider_ply = g_replay_ply;
+    GuiSliderBar((Rectangle){SCREEN_WIDTH / 4, 32, SCREEN_WIDTH / 2, 20}, "Move", TextFormat("%d/%d", g_replay_ply, header.move_count), &slider_ply, 0, header.move_count);
+    if ((int)roundf(slider_ply) != g_replay_ply)
+        seek_replay(g_replay_index, roundf(slider_ply));
+
+    // draw the board of the shown move, with the last move outlined
+    for (int i = 0; i < ROW; i++)
+        for (int j = 0; j < COLUMN; j++)
+        {
+            int cell = i * COLUMN + j;
+            int x_coord = j * CELL_WIDTH;
+            int y_coord = i * CELL_HEIGHT + UI_OFFSET;
+            DrawRectangleLines(x_coord, y_coord, CELL_WIDTH, CELL_HEIGHT, TITLE_COLOUR);
+            render_tile(x_coord, y_coord, (g_replay_board.cross >> cell) & 1 ? CROSS : (g_replay_board.circle >> cell) & 1 ? CIRCLE : EMPTY);
+            if (g_replay_ply > 0 && moves[g_replay_ply - 1] == cell)
+                DrawRectangleLinesEx((Rectangle){x_coord, y_coord, CELL_WIDTH, CELL_HEIGHT}, 6, (Color){255, 0, 0, 150});
+        }
+
+    TRACE_CALL("EndDrawing", EndDrawing());
+}
+
+/*
+Plays back every replay of a replay file on a bitboard and adds up the results by gamemode and first move
+Returns the number of bytes that were read, which is less than size if an invalid replay was found
+*/
+size_t count_replay_stats(const unsigned char *data, size_t size, Replay_Stats *stats)
+{
+    Replay_Header header;
+    const unsigned char *moves;
+    size_t offset = sizeof(Replay_File_Header);
+
+    while (offset < size)
+    {
+        size_t next_offset = read_replay(data, size, offset, &header, &moves);
+        if (next_offset == 0)
+            break;
+
+        Tile winner = get_bitboard_winner(replay_to_ply(moves, header.move_count));
+        int result = winner != EMPTY ? winner : header.move_count == REPLAY_MAX_MOVES ? EMPTY : REPLAY_UNFINISHED;
+
+        stats->results[header.gamemode][result]++;
+        stats->move_count[header.gamemode] += header.move_count;
+        if (header.move_count > 0)
+            stats->first_move_results[moves[0]][result]++;
+        stats->replay_count++;
+        offset = next_offset;
+    }
+
+    return offset;
+}
+
+/*
+Reads a replay file and prints the results of every gamemode, the results of every first move and how fast the file was read
+*/
+void run_replay_stats(char file_name[])
+{
+    size_t size = 0;
+    unsigned char *data = read_whole_file(file_name, &size);
+
+    const Replay_File_Header *file_header = (const Replay_File_Header *)data;
+    if (data == NULL || size < sizeof(Replay_File_Header) ||
+        memcmp(file_header->magic, REPLAY_MAGIC, sizeof(file_header->magic)) != 0 || file_header->version != REPLAY_VERSION)
+    {
+        printf("Invalid replay file: %s\n", file_name);
+        exit(1);
+    }
+
+    Replay_Stats stats;
+    memset(&stats, 0, sizeof(stats));
+    unsigned long long start_ns = get_monotonic_ns();
+    size_t read_size = count_replay_stats(data, size, &stats);
+    double elapsed_time = get_seconds_since(start_ns);
+
+    if (read_size < size)
+        printf("Invalid replay at offset %zu, the rest of the file is skipped\n", read_size);
+
+    printf("%-18s %10s %8s %8s %8s %10s %8s\n", "gamemode", "games", "x wins", "o wins", "draws", "unfinished", "moves");
+    for (int i = 0; i < REPLAY_GAMEMODE_COUNT; i++)
+    {
+        long long game_count = stats.results[i][EMPTY] + stats.results[i][CROSS] + stats.results[i][CIRCLE] + stats.results[i][REPLAY_UNFINISHED];
+        if (game_count > 0)
+            printf("%-18s %10lld %8lld %8lld %8lld %10lld %8.2f\n", GAMEMODE_NAMES[i], game_count, stats.results[i][CROSS], stats.results[i][CIRCLE],
+                   stats.results[i][EMPTY], stats.results[i][REPLAY_UNFINISHED], (double)stats.move_count[i] / game_count);
+    }
+
+    printf("\n%-18s %10s %8s %8s %8s\n", "first move", "games", "x wins", "o wins", "draws");
+    for (int i = 0; i < ROW * COLUMN; i++)
+    {
+        long long game_count = stats.first_move_results[i][EMPTY] + stats.first_move_results[i][CROSS] + stats.first_move_results[i][CIRCLE] + stats.first_move_results[i][REPLAY_UNFINISHED];
+        printf("row %d column %d     %10lld %8lld %8lld %8lld\n", i / COLUMN, i % COLUMN, game_count, stats.first_move_results[i][CROSS],
+               stats.first_move_results[i][CIRCLE], stats.first_move_results[i][EMPTY]);
     }
-    return 1;
+
+    printf("\n%lld replays (%zu bytes) in %.3f s (%.0f replays/s)\n", stats.replay_count, size, elapsed_time, stats.replay_count / fmax(elapsed_time, 1e-9));
+    free(data);
 }
 
 /*
-Evaluate the current board and return 1 if g_player_two has won, -1 if g_player_one has won.
-Reset the gp_winner pointer to NULL after evaluation. Mainly used for minimax algorithm.
+Sets up the analysis of a square board with a transposition table of 2^table_bits entries
 */
-int evaluate()
+void analysis_init(Analysis *analysis, int board_size, int table_bits)
 {
-    check_win_condition();
+    memset(analysis, 0, sizeof(Analysis));
+    // only the winning lines of the solver are used, the analysis stores depths in its own table
+    board_solver_init(&analysis->solver, board_size, 0);
 
-    // if g_player_two has won, return 1, reset gp_winner to NULL
-    if (gp_winner == &g_player_two)
-    {
-        gp_winner = NULL;
-        return 1;
-    }
-    else if (gp_winner == &g_player_one)
+    analysis->table_mask = (1ULL << table_bits) - 1;
+    analysis->table = malloc((analysis->table_mask + 1) * sizeof(Analysis_Entry));
+    if (!analysis->table)
     {
-        gp_winner = NULL;
-        return -1;
+        printf("Error allocating memory for the analysis table\n");
+        exit(1);
     }
+    // clear the table here instead of with calloc, so that its pages are not first touched in the middle of a frame
+    memset(analysis->table, 0, (analysis->table_mask + 1) * sizeof(Analysis_Entry));
+    analysis->finished = true;
+}
 
-    return 0;
+/*
+Frees the transposition table and the solver of the analysis
+*/
+void analysis_free(Analysis *analysis)
+{
+    free(analysis->table);
+    analysis->table = NULL;
+    board_solver_free(&analysis->solver);
 }
 
 /*
-Returns a boolean value if the current grid is a winning condition and updates gp_winner
-Variables g_winner_start and g_winner_end are the start and end position of the winning line
-It returns a boolean if there is a win, but also updates the gp_winner pointer to the winner
+Starts analysing a new position, nothing is reset if it is the position that is already analysed
+The transposition table is kept, so positions that were searched before the last move are not searched again
 */
-bool check_win_condition()
+void analysis_set_position(Analysis *analysis, Bitboard board)
 {
-    Tile temp;
-    // loop through each row, and compare columns
-    // algo to check each row
-    for (int i = 0; i < ROW; i++)
-        for (int j = 0; j < COLUMN; j++)
-        {
-            if (j == 0)
-            {
-                temp = g_grid[i][j];
-                g_winner_start = (Move){i, j};
-                continue;
-            }
-            else if (temp != g_grid[i][j])
-            {
-                temp = EMPTY;
-                break;
-            }
-            else if (j == COLUMN - 1)
-            {
-                if (g_player_one.tile == temp)
-                {
-                    gp_winner = &g_player_one;
-                    g_winner_end = (Move){i, j};
-                    return true;
-                }
-                else if (g_player_two.tile == temp)
-                {
-                    gp_winner = &g_player_two;
-                    g_winner_end = (Move){i, j};
-                    return true;
-                }
-            }
-        }
+    if (analysis->depth > 0 && analysis->root.cross == board.cross && analysis->root.circle == board.circle)
+        return;
 
-    // loop through each column, and compare rows
-    // algo to check each column
-    for (int i = 0; i < COLUMN; i++)
-        for (int j = 0; j < ROW; j++)
-        {
-            if (j == 0)
-            {
-                temp = g_grid[j][i];
-                g_winner_start = (Move){j, i};
-                continue;
-            }
-            else if (temp != g_grid[j][i])
-            {
-                temp = EMPTY;
-                break;
-            }
-            else if (j == ROW - 1)
-            {
-                if (g_player_one.tile == temp)
-                {
-                    gp_winner = &g_player_one;
-                    g_winner_end = (Move){j, i};
-                    return true;
-                }
-                else if (g_player_two.tile == temp)
-                {
-                    gp_winner = &g_player_two;
-                    g_winner_end = (Move){j, i};
-                    return true;
-                }
-            }
-        }
+    analysis->root = board;
+    analysis->depth = 1;
+    analysis->next_cell = 0;
+    analysis->completed_depth = 0;
+    analysis->finished = is_position_over(&analysis->solver, board);
+}
 
-    // algo to check top left to bottom right diagonal
-    for (int i = 0; i < ROW; i++)
-    {
-        if (i == 0)
-        {
-            temp = g_grid[i][i];
-            g_winner_start = (Move){i, i};
-            continue;
-        }
-        else if (temp != g_grid[i][i])
-        {
-            temp = EMPTY;
-            break;
-        }
-        else if (i == ROW - 1)
-        {
-            if (g_player_one.tile == temp)
-            {
-                gp_winner = &g_player_one;
-                g_winner_end = (Move){i, i};
-                return true;
-            }
-            else if (g_player_two.tile == temp)
-            {
-                gp_winner = &g_player_two;
-                g_winner_end = (Move){i, i};
-                return true;
-            }
-        }
-    }
+/*
+Returns the value of a position for the player to move when the search cannot look further ahead
+Every line that the opponent has no tile in counts for the player, more for every tile the player already has in it
+*/
+int evaluate_analysis_board(const Board_Solver *solver, unsigned long long own, unsigned long long opponent)
+{
+    int value = 0;
 
-    // algo to check bottom left to top right diagonal
-    for (int i = 0; i < ROW; i++)
+    for (int i = 0; i < solver->line_count; i++)
     {
-        if (i == 0)
-        {
-            temp = g_grid[ROW - 1 - i][i];
-            g_winner_start = (Move){ROW - 1 - i, i};
-            continue;
-        }
-        else if (temp != g_grid[ROW - 1 - i][i])
-        {
-            temp = EMPTY;
-            break;
-        }
-        else if (i == ROW - 1)
-        {
-            if (g_player_one.tile == temp)
-            {
-                gp_winner = &g_player_one;
-                g_winner_end = (Move){ROW - 1 - i, i};
-                return true;
-            }
-            else if (g_player_two.tile == temp)
-            {
-                gp_winner = &g_player_two;
-                g_winner_end = (Move){ROW - 1 - i, i};
-                return true;
-            }
-        }
+        int own_count = __builtin_popcountll(solver->line_masks[i] & own);
+        int opponent_count = __builtin_popcountll(solver->line_masks[i] & opponent);
+        if (opponent_count == 0)
+            value += own_count * own_count;
+        if (own_count == 0)
+            value -= opponent_count * opponent_count;
     }
 
-    return false;
+    return value;
 }
 
 /*
-Recursive function that calculates the minimax value of the current board state,
-implemented with alpha-beta pruning.
+Negamax search with alpha-beta pruning to a depth, using the transposition table of the analysis
+Wins are worth ANALYSIS_WIN_VALUE plus the empty cells left, so the value of a position does not depend on how it was reached
+Stops with aborted set once the deadline of the step has passed
 */
-int mini_max(int depth, int is_max, int max_depth, int alpha, int beta)
+int analysis_search(Analysis *analysis, Bitboard board, int depth, int alpha, int beta)
 {
-    int score = evaluate();
+    const Board_Solver *solver = &analysis->solver;
+    bool cross_to_move = __builtin_popcountll(board.cross) == __builtin_popcountll(board.circle);
+    unsigned long long occupied = board.cross | board.circle;
+    unsigned long long own = cross_to_move ? board.cross : board.circle;
+    unsigned long long opponent = cross_to_move ? board.circle : board.cross;
+    int empty_count = solver->cell_count - __builtin_popcountll(occupied);
+
+    // the previous move won the game for the opponent
+    if (has_winning_line(solver, opponent))
+        return -(ANALYSIS_WIN_VALUE + empty_count);
+    // the board is full without a winner
+    if (empty_count == 0)
+        return 0;
 
-    if (score != 0)
-        return score;
-    if (is_board_full() || depth == max_depth)
+    // the player to move wins right away if a line only misses one empty cell
+    for (int i = 0; i < solver->line_count; i++)
+    {
+        unsigned long long missing = solver->line_masks[i] & ~own;
+        if ((missing & (missing - 1)) == 0 && (missing & occupied) == 0)
+            return ANALYSIS_WIN_VALUE + empty_count - 1;
+    }
+
+    // check the time every few positions, the step is continued from the transposition table in the next frame
+    if ((++analysis->node_count & (ANALYSIS_CHECK_INTERVAL - 1)) == 0 && get_monotonic_ns() > analysis->deadline_ns)
+        analysis->aborted = true;
+    if (analysis->aborted)
         return 0;
 
-    // initalize a best value base on the current player (max or min)
-    int best_val = is_max ? -1000 : 1000;
+    if (depth <= 0)
+        return evaluate_analysis_board(solver, own, opponent);
 
-    // loop through the board cells
-    for (int i = 0; i < ROW; i++)
+    // use the stored value if this position has been searched at least as deep, else search its best move first
+    Analysis_Entry *entry = &analysis->table[hash_bitboard(board) & analysis->table_mask];
+    int original_alpha = alpha;
+    int first_cell = -1;
+    if (entry->bound != SOLVER_BOUND_NONE && entry->board.cross == board.cross && entry->board.circle == board.circle)
     {
-        for (int j = 0; j < COLUMN; j++)
+        first_cell = entry->best_cell;
+        if (entry->depth >= depth)
         {
-            if (g_grid[i][j] == EMPTY)
-            {
-                // temporarily set the cell with the current player's tile
-                g_grid[i][j] = is_max ? g_player_two.tile : g_player_one.tile;
-
-                // recursively calculate the minimax value
-                int move_val = mini_max(depth + 1, !is_max, max_depth, alpha, beta);
-
-                // update the best value based on the current player (max or min)
-                best_val = is_max ? fmax(best_val, move_val) : fmin(best_val, move_val);
+            if (entry->bound == SOLVER_BOUND_EXACT)
+                return entry->value;
+            if (entry->bound == SOLVER_BOUND_LOWER && entry->value > alpha)
+                alpha = entry->value;
+            else if (entry->bound == SOLVER_BOUND_UPPER && entry->value < beta)
+                beta = entry->value;
+            if (alpha >= beta)
+                return entry->value;
+        }
+    }
 
-                // undo the move (backtrack)
-                g_grid[i][j] = EMPTY;
+    int best_value = -ANALYSIS_INFINITY;
+    int best_cell = -1;
+    for (int i = -1; i < solver->cell_count; i++)
+    {
+        // the best move of the last search is tried first, then every other cell in order
+        int cell = i < 0 ? first_cell : i;
+        if (cell < 0 || (i >= 0 && cell == first_cell) || (occupied & (1ULL << cell)))
+            continue;
 
-                // alpha-beta pruning codes
-                if (is_max)
-                {
-                    alpha = fmax(alpha, move_val);
-                }
-                else
-                {
-                    beta = fmin(beta, move_val);
-                }
+        Bitboard child = board;
+        if (cross_to_move)
+            child.cross |= 1ULL << cell;
+        else
+            child.circle |= 1ULL << cell;
 
-                /*
-                if beta is less than or equal to alpha, break out of the loop
-                as the rest of the moves will not be considered
-                */
-                if (beta <= alpha)
-                {
-                    break;
-                }
-            }
+        int value = -analysis_search(analysis, child, depth - 1, -beta, -alpha);
+        if (analysis->aborted)
+            return 0;
+        if (value > best_value)
+        {
+            best_value = value;
+            best_cell = cell;
         }
+        if (best_value > alpha)
+            alpha = best_value;
+        if (alpha >= beta)
+            break;
     }
 
-    return best_val;
+    entry->board = board;
+    entry->value = best_value;
+    entry->depth = depth;
+    entry->best_cell = best_cell;
+    entry->bound = best_value <= original_alpha ? SOLVER_BOUND_UPPER : best_value >= beta ? SOLVER_BOUND_LOWER : SOLVER_BOUND_EXACT;
+
+    return best_value;
 }
 
 /*
-Returns the best move for the minimax player using the minimax algorithm
+Searches the root moves of the analysis for up to budget_ns, continuing where the last step stopped
+Every root move is searched with a full window so that each cell gets its own value, and the values are published once every root move is searched to the same depth
+The depth then grows by one until the values are exact
 */
-Move get_mini_max_best_move()
+void analysis_step(Analysis *analysis, unsigned long long budget_ns)
 {
-    // set initial difficult of miniMax mod to easy to look only 1 move ahead
-    int difficulty = 0;
+    const Board_Solver *solver = &analysis->solver;
+    unsigned long long occupied = analysis->root.cross | analysis->root.circle;
+    bool cross_to_move = __builtin_popcountll(analysis->root.cross) == __builtin_popcountll(analysis->root.circle);
 
-    // if difficulty is medium or hard update difficulty
-    if (g_game_difficulty_mode == MEDIUM)
-        difficulty = 1;
-    else if (g_game_difficulty_mode == HARD)
-        difficulty = (ROW * COLUMN) - 1; // look ahead all the way to the end
+    analysis->deadline_ns = get_monotonic_ns() + budget_ns;
+    analysis->aborted = false;
 
-    // initial best value to a very low value
-    int best_val = -1000;
+    while (!analysis->finished && get_monotonic_ns() < analysis->deadline_ns)
+    {
+        while (analysis->next_cell < solver->cell_count && (occupied & (1ULL << analysis->next_cell)))
+            analysis->next_cell++;
 
-    // initialize best move row and column value
-    Move best_move = {-1, -1};
+        // every root move has been searched to this depth, the values are exact once the depth reaches the end of the game
+        if (analysis->next_cell == solver->cell_count)
+        {
+            memcpy(analysis->values, analysis->pending_values, sizeof(analysis->values));
+            analysis->completed_depth = analysis->depth;
+            analysis->finished = analysis->depth >= solver->cell_count - __builtin_popcountll(occupied);
+            analysis->depth++;
+            analysis->next_cell = 0;
+            continue;
+        }
 
-    // loop through the board cells
+        Bitboard child = analysis->root;
+        if (cross_to_move)
+            child.cross |= 1ULL << analysis->next_cell;
+        else
+            child.circle |= 1ULL << analysis->next_cell;
+
+        int value = -analysis_search(analysis, child, analysis->depth - 1, -ANALYSIS_INFINITY, ANALYSIS_INFINITY);
+        // the root move is searched again in the next step, most of its positions are then in the table
+        if (analysis->aborted)
+            return;
+        analysis->pending_values[analysis->next_cell++] = value;
+    }
+}
+
+/*
+Draws the value of every empty cell of the game over the board as a heatmap, green is good for the player to move and red is bad
+The analysis searches for a short time every frame, so the values get more accurate while the board is shown
+*/
+void render_analysis()
+{
+    Bitboard board = {0, 0};
     for (int i = 0; i < ROW; i++)
-    {
         for (int j = 0; j < COLUMN; j++)
-        {
-            // if cell is empty, attempt move and see if it is the best move
-            if (g_grid[i][j] == EMPTY)
-            {
-                g_grid[i][j] = g_player_two.tile;
-                int move_val = mini_max(0, 0, difficulty, -1000, 1000);
-                g_grid[i][j] = EMPTY;
-                // if move_val is better than best_val, update best_val and best_move_row and best_move_column
-                if (move_val > best_val)
-                {
-                    best_move.row = i;
-                    best_move.column = j;
-                    best_val = move_val;
-                }
-            }
+            if (g_grid[i][j] == CROSS)
+                board.cross |= 1ULL << (i * COLUMN + j);
+            else if (g_grid[i][j] == CIRCLE)
+                board.circle |= 1ULL << (i * COLUMN + j);
+
+    analysis_set_position(&g_analysis, board);
+    TRACE_CALL("analysis_step", analysis_step(&g_analysis, ANALYSIS_FRAME_BUDGET_NS));
+
+    if (g_analysis.completed_depth == 0)
+        return;
+
+    int empty_count = ROW * COLUMN - __builtin_popcountll(board.cross | board.circle);
+    int heuristic_range = 4 * ROW * COLUMN;
+    for (int i = 0; i < ROW; i++)
+        for (int j = 0; j < COLUMN; j++)
+        {
+            if (g_grid[i][j] != EMPTY)
+                continue;
+
+            int value = g_analysis.values[i * COLUMN + j];
+            // wins and losses are at the ends of the heatmap, the other values are spread around the middle
+            float heat = value >= ANALYSIS_WIN_VALUE ? 1 : value <= -ANALYSIS_WIN_VALUE ? 0 : 0.5f + Clamp((float)value / heuristic_range, -0.4f, 0.4f);
+            int x_coord = j * CELL_WIDTH;
+            int y_coord = i * CELL_HEIGHT + UI_OFFSET;
+            DrawRectangle(x_coord, y_coord, CELL_WIDTH, CELL_HEIGHT, (Color){(1 - heat) * 220, heat * 180, 60, 110});
+
+            // the number of moves until the end of the game is known from the empty cells left in the value
+            const char *value_text = TextFormat("%+d", value);
+            if (value >= ANALYSIS_WIN_VALUE)
+                value_text = TextFormat("Win in %d", empty_count - (value - ANALYSIS_WIN_VALUE));
+            else if (value <= -ANALYSIS_WIN_VALUE)
+                value_text = TextFormat("Loss in %d", empty_count + (value + ANALYSIS_WIN_VALUE));
+            else if (g_analysis.finished)
+                value_text = "Draw";
+            DrawText(value_text, x_coord + CELL_WIDTH / 2 - MeasureText(value_text, 30) / 2, y_coord + CELL_HEIGHT / 2 - 15, 30, TITLE_COLOUR);
         }
-    }
 
-    // return the best move
-    return best_move;
+    // draw the depth of the values in the corner of the text ui
+    const char *depth_text = TextFormat("Depth %d%s", g_analysis.completed_depth, g_analysis.finished ? " (exact)" : "");
+    DrawText(depth_text, SCREEN_WIDTH - MeasureText(depth_text, 20) - 10, UI_OFFSET / 3, 20, TITLE_COLOUR);
 }
 
 /*
-Takes in a file name and read the dataset into g_dataset_array
+Analyses the empty board of a board size for a number of frames with the time budget of the game
+Prints the time of the steps, the depth that was reached and the value of every cell
 */
-void read_ml_dataset(char file_name[])
+void run_analysis_bench(int board_size, int frame_count)
 {
-    // attempt to open file for reading
-    FILE *dataset_file = fopen(file_name, "r");
-
-    // error checking for file opening
-    if (!dataset_file)
+    if (board_size < 3 || board_size > MAX_BOARD_SIZE)
     {
-        printf("Error opening file %s\n", file_name);
+        printf("Board size must be between 3 and %d\n", MAX_BOARD_SIZE);
         exit(1);
     }
 
-    char line[MAX_DATAROW_SIZE];
-    // read from data in lines into the struct
-    while (g_dataset_count < MAX_DATASET_SIZE && fgets(line, sizeof(line), dataset_file))
-    {
-        // remove the newline character from the end of each line
-        line[strcspn(line, "\n")] = '\0';
+    Analysis analysis;
+    analysis_init(&analysis, board_size, ANALYSIS_TABLE_BITS);
+    analysis_set_position(&analysis, (Bitboard){0, 0});
 
-        // go through each character in the line and assign respective tile to the struct
-        for (int i = 0; i < 17; i += 2) // skips the comma
-        {
-            if (line[i] == 'x')
-                g_dataset_array[g_dataset_count].tile[i / 2] = CROSS;
-            else if (line[i] == 'o')
-                g_dataset_array[g_dataset_count].tile[i / 2] = CIRCLE;
-            else if (line[i] == 'b')
-                g_dataset_array[g_dataset_count].tile[i / 2] = EMPTY;
-        }
+    unsigned long long total_step_ns = 0, max_step_ns = 0;
+    int frame = 0;
+    for (; frame < frame_count && !analysis.finished; frame++)
+    {
+        unsigned long long start_ns = get_monotonic_ns();
+        analysis_step(&analysis, ANALYSIS_FRAME_BUDGET_NS);
+        unsigned long long step_ns = get_monotonic_ns() - start_ns;
 
-        // reverse search line and get the last token which is either POSTIIVE or NEGATIVE
-        char *token = strrchr(line, ',') + 1;
+        total_step_ns += step_ns;
+        if (step_ns > max_step_ns)
+            max_step_ns = step_ns;
+    }
 
-        // set the current row result to the token value positive or negative
-        g_dataset_array[g_dataset_count].result = strcmp(token, "positive") == 0 ? POSITIVE : NEGATIVE;
+    printf("%dx%d board, %d frames: %.3f ms per frame on average, %.3f ms at most, budget %.3f ms\n", board_size, board_size, frame,
+           total_step_ns / 1e6 / fmax(frame, 1), max_step_ns / 1e6, ANALYSIS_FRAME_BUDGET_NS / 1e6);
+    printf("depth %d%s, %llu positions searched\n", analysis.completed_depth, analysis.finished ? " (exact)" : "", analysis.node_count);
 
-        // g_dataset_count is the total number of lines in dataset
-        g_dataset_count++;
+    for (int i = 0; i < board_size && analysis.completed_depth > 0; i++)
+    {
+        for (int j = 0; j < board_size; j++)
+            printf("%7d", analysis.values[i * board_size + j]);
+        printf("\n");
     }
 
-    fclose(dataset_file);
+    analysis_free(&analysis);
 }
 
 /*
-shuffle the dataset array using fisher yates algorithm shuffle
+Returns the next number of a splitmix64 sequence and advances the state, only used by random_seed to fill the state of a Random
+Everything else draws its numbers from a Random
 */
-void shuffle_dataset()
+unsigned long long splitmix64_next(unsigned long long *state)
 {
-    // fisher yates shuffle
-    // initialize random seed so that the shuffle is different each time
-    srand(time(NULL));
-
-    // loop through the dataset array and swap the current index with a random index
-    for (int i = g_dataset_count - 1; i > 0; i--)
-    {
-        int j;
+    unsigned long long value = (*state += 0x9E3779B97F4A7C15ULL);
 
-        // keep generating random index until it is not the same as i
-        do
-        {
-            j = rand() % (i + 1);
-        } while (i == j);
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    return value ^ (value >> 31);
+}
 
-        // swap the current index with the random index
-        ML_Data_Row temp_data_row = g_dataset_array[i];
-        g_dataset_array[i] = g_dataset_array[j];
-        g_dataset_array[j] = temp_data_row;
-    }
+/*
+Seeds the xoshiro256** generator, the state is filled from the seed with splitmix64 so that any seed gives a good state
+*/
+void random_seed(Random *random, unsigned long long seed)
+{
+    for (int i = 0; i < 4; i++)
+        random->state[i] = splitmix64_next(&seed);
 }
 
 /*
-Train the naive bayes probability algorithm and store the probability in g_naive_bayes_probability
+Returns the next 64 bit number of the xoshiro256** generator and advances its state
 */
-void naive_bayes_learn(float training_data_weight)
+unsigned long long random_next(Random *random)
 {
-    // reset counters and probability array
-    g_positive_counter = 0;
-    g_negative_counter = 0;
-    memset(g_naive_bayes_probability, 0, sizeof(g_naive_bayes_probability));
+    unsigned long long *state = random->state;
+    unsigned long long result = state[1] * 5;
+    result = ((result << 7) | (result >> 57)) * 9;
+    unsigned long long shifted = state[1] << 17;
+
+    state[2] ^= state[0];
+    state[3] ^= state[1];
+    state[1] ^= state[2];
+    state[0] ^= state[3];
+    state[2] ^= shifted;
+    state[3] = (state[3] << 45) | (state[3] >> 19);
+
+    return result;
+}
 
-    // only use a portion of the total dataset for learning
-    int training_data_count = ceil(g_dataset_count * training_data_weight);
+/*
+Returns a uniform random number between 0 and bound - 1
+Numbers below 2^64 % bound are rejected so that every result is equally likely, unlike rand() % bound
+*/
+unsigned long long random_below(Random *random, unsigned long long bound)
+{
+    unsigned long long threshold = -bound % bound;
+    unsigned long long value;
 
-    // loop through the training data and calculate the probability of each tile
-    for (int i = 0; i < training_data_count; i++)
+    do
     {
-        // get the current training data
-        ML_Data_Row current_row = g_dataset_array[i];
+        value = random_next(random);
+    } while (value < threshold);
 
-        // increment the positive and negative counter
-        if (current_row.result == POSITIVE)
-        {
-            g_positive_counter++;
-        }
-        else if (current_row.result == NEGATIVE)
-        {
-            g_negative_counter++;
-        }
+    return value % bound;
+}
 
-        /*
-        increment the count of each tile in g_naive_bayes_probability, where
-        for each row, first 3 columns are positive {Xp, Op, Bp}, last 3 columns are negative {Xn, On, Bn}
-        row_offset will offset the array index depending whether the current result is positive or negative
-        */
-        int row_offset = current_row.result == POSITIVE ? 0 : 3;
+/*
+Returns a uniform random number between 0 and 1, not including 1, from the top 24 bits so that every float is exact
+*/
+float random_float(Random *random)
+{
+    return (random_next(random) >> 40) * 0x1.0p-24f;
+}
 
-        for (int row = 0; row < 9; row++)
-        {
-            switch (current_row.tile[row])
-            {
-            case CROSS:
-                g_naive_bayes_probability[row][0 + row_offset]++;
-                break;
-            case CIRCLE:
-                g_naive_bayes_probability[row][1 + row_offset]++;
-                break;
-            case EMPTY:
-                g_naive_bayes_probability[row][2 + row_offset]++;
-                break;
-            }
-        }
-    }
+/*
+Shuffles count elements of element_size bytes with the fisher yates algorithm
+*/
+void shuffle_elements(void *elements, size_t element_size, int count, Random *random)
+{
+    char *bytes = elements;
+    char temp[element_size];
 
-    /*
-    calculate the probability of each tile by taking the total
-    occurence of state of the cell / total occurence of positive or negative
-    */
-    for (int row = 0; row < 9; row++)
+    // swap every element with a random element at or before it, which may be itself
+    for (int i = count - 1; i > 0; i--)
     {
-        for (int col = 0; col < 6; col++)
-        {
-            // first 3 columns are positive {Xp, Op, Bp}, last 3 columns are negative {Xn, On, Bn}
-            g_naive_bayes_probability[row][col] /= col < 3 ? g_positive_counter : g_negative_counter;
-        }
-    }
+        int j = random_below(random, i + 1);
 
-    // we reuse the counters to store prior probability of positive p(P) and negative p(N)
-    g_positive_counter /= training_data_count;
-    g_negative_counter /= training_data_count;
+        memcpy(temp, bytes + i * element_size, element_size);
+        memcpy(bytes + i * element_size, bytes + j * element_size, element_size);
+        memcpy(bytes + j * element_size, temp, element_size);
+    }
 }
 
 /*
-converts the current grid into a ML_Data_Row struct
+Sends every element of a chunk to a random block, ran by the worker threads of run_parallel
+The first pass only counts the elements of each block, the second pass draws the same blocks again and copies the elements
 */
-ML_Data_Row get_current_grid()
+void shuffle_scatter_task(int chunk, void *context)
 {
-    // initialize the current row as a ML_Data_Row struct
-    ML_Data_Row current_row;
+    Parallel_Shuffle *shuffle = context;
+    int chunk_start = (long long)chunk * shuffle->count / SHUFFLE_BLOCK_COUNT;
+    int chunk_end = (long long)(chunk + 1) * shuffle->count / SHUFFLE_BLOCK_COUNT;
+    Random random;
 
-    // loop through the grid and convert the 2d array into a 1d array
-    for (int i = 0; i < ROW; i++)
+    random_seed(&random, shuffle->seed + chunk);
+
+    for (int i = chunk_start; i < chunk_end; i++)
     {
-        for (int j = 0; j < COLUMN; j++)
-        {
-            /*
-            As the ML data set is trained to predict X to win, this function must be modular
-            to account for the AI player to be either X or O
-            */
-            if (g_player_two.tile == CIRCLE)
-            {
-                if (g_grid[i][j] == CIRCLE)
-                    current_row.tile[i * 3 + j] = CROSS;
-                else if (g_grid[i][j] == CROSS)
-                    current_row.tile[i * 3 + j] = CIRCLE;
-                else
-                    current_row.tile[i * 3 + j] = g_grid[i][j];
-            }
-            else
-                current_row.tile[i * 3 + j] = g_grid[i][j];
-        }
+        int block = random_below(&random, SHUFFLE_BLOCK_COUNT);
+
+        if (shuffle->scattering)
+            memcpy(shuffle->buffer + (size_t)shuffle->offsets[chunk][block]++ * shuffle->element_size,
+                   shuffle->elements + (size_t)i * shuffle->element_size, shuffle->element_size);
+        else
+            shuffle->offsets[chunk][block]++;
     }
+}
 
-    return current_row;
+/*
+Shuffles the elements of one block with fisher yates, ran by the worker threads of run_parallel
+*/
+void shuffle_block_task(int block, void *context)
+{
+    Parallel_Shuffle *shuffle = context;
+    Random random;
+
+    random_seed(&random, shuffle->seed + SHUFFLE_BLOCK_COUNT + block);
+    shuffle_elements(shuffle->buffer + (size_t)shuffle->block_starts[block] * shuffle->element_size, shuffle->element_size,
+                     shuffle->block_starts[block + 1] - shuffle->block_starts[block], &random);
 }
 
 /*
-Takes in a ML_Data_Row struct and returns the predicted result of the function parameter data
+Shuffles count elements of element_size bytes, in parallel when there are at least PARALLEL_SHUFFLE_THRESHOLD elements
+Every element is sent to a random block and then every block is shuffled on its own, which gives a uniform shuffle
+The chunks and blocks are fixed, so the result only depends on the random generator and not on the number of threads
 */
-Predicted_Result naive_bayes_predict(ML_Data_Row data)
+void parallel_shuffle(void *elements, size_t element_size, int count, Random *random)
 {
-    // initialize prior probablity p(P) and p(N)
-    double positive_probability = g_positive_counter;
-    double negative_probability = g_negative_counter;
-    Predicted_Result predicted_result;
+    if (count < PARALLEL_SHUFFLE_THRESHOLD)
+    {
+        shuffle_elements(elements, element_size, count, random);
+        return;
+    }
 
-    // loop through each tile and multiply the probability into the prior probability
-    // column 0 - X positive
-    // column 1 - O positive
-    // column 2 - B positive
-    // column 3 - X negative
-    // column 4 - O negative
-    // column 5 - B negative
-    for (int i = 0; i < 9; i++)
+    Parallel_Shuffle *shuffle = calloc(1, sizeof(Parallel_Shuffle));
+    char *buffer = malloc(element_size * count);
+    if (shuffle == NULL || buffer == NULL)
+    {
+        printf("Failed to allocate memory for shuffling %d elements\n", count);
+        exit(1);
+    }
+
+    shuffle->elements = elements;
+    shuffle->buffer = buffer;
+    shuffle->element_size = element_size;
+    shuffle->count = count;
+    shuffle->seed = random_next(random);
+
+    // count the elements that every chunk sends to every block
+    run_parallel(shuffle_scatter_task, SHUFFLE_BLOCK_COUNT, shuffle);
+
+    // turn the counts into the offset of every chunk in every block, the blocks are laid out one after another
+    int offset = 0;
+    for (int block = 0; block < SHUFFLE_BLOCK_COUNT; block++)
     {
-        switch (data.tile[i])
+        shuffle->block_starts[block] = offset;
+        for (int chunk = 0; chunk < SHUFFLE_BLOCK_COUNT; chunk++)
         {
-        case CROSS:
-            positive_probability *= g_naive_bayes_probability[i][0];
-            negative_probability *= g_naive_bayes_probability[i][3];
-            break;
-        case CIRCLE:
-            positive_probability *= g_naive_bayes_probability[i][1];
-            negative_probability *= g_naive_bayes_probability[i][4];
-            break;
-        case EMPTY:
-            positive_probability *= g_naive_bayes_probability[i][2];
-            negative_probability *= g_naive_bayes_probability[i][5];
-            break;
+            int chunk_count = shuffle->offsets[chunk][block];
+            shuffle->offsets[chunk][block] = offset;
+            offset += chunk_count;
         }
     }
+    shuffle->block_starts[SHUFFLE_BLOCK_COUNT] = offset;
+
+    // copy the elements into their blocks, then shuffle every block
+    shuffle->scattering = true;
+    run_parallel(shuffle_scatter_task, SHUFFLE_BLOCK_COUNT, shuffle);
+    run_parallel(shuffle_block_task, SHUFFLE_BLOCK_COUNT, shuffle);
+
+    memcpy(elements, buffer, element_size * count);
+    free(buffer);
+    free(shuffle);
+}
 
-    // compare whether the positive or negative is higher, the higher of those will be the predicted probability
-    if (fmax(positive_probability, negative_probability) == positive_probability)
+/*
+Returns a shuffled array of the indices 0 to count - 1, which must be freed by the caller
+Used to visit the dataset in a random order without moving any of the rows
+*/
+int *create_permutation(int count, Random *random)
+{
+    int *order = malloc(sizeof(int) * (count > 0 ? count : 1));
+    if (order == NULL)
     {
-        predicted_result.result = POSITIVE;
-        predicted_result.score = positive_probability;
+        printf("Failed to allocate memory for a permutation of %d indices\n", count);
+        exit(1);
     }
-    else
+
+    for (int i = 0; i < count; i++)
+        order[i] = i;
+    parallel_shuffle(order, sizeof(int), count, random);
+
+    return order;
+}
+
+/*
+Returns the number of threads to use for parallel work, which is the number of cores on the computer
+*/
+int get_thread_count()
+{
+#if defined(_WIN32)
+    int thread_count = pthread_num_processors_np();
+#else
+    int thread_count = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+
+    return thread_count < 1 ? 1 : thread_count > MAX_THREAD_COUNT ? MAX_THREAD_COUNT : thread_count;
+}
+
+/*
+Keeps taking the next task of the job until there are no tasks left
+*/
+void run_parallel_tasks(Parallel_Job *job)
+{
+    int task_index;
+
+    while ((task_index = __atomic_fetch_add(&job->next_task, 1, __ATOMIC_RELAXED)) < job->task_count)
+        TRACE_CALL("parallel_task", job->task(task_index, job->context));
+}
+
+/*
+Worker thread of the pool, sleeps until a job is posted, runs its tasks, then goes back to sleep
+*/
+void *parallel_worker(void *argument)
+{
+    Parallel_Pool *pool = argument;
+    unsigned long long last_job_number = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    while (true)
     {
-        predicted_result.result = NEGATIVE;
-        predicted_result.score = negative_probability;
+        while (pool->job_number == last_job_number)
+            pthread_cond_wait(&pool->job_posted, &pool->lock);
+        last_job_number = pool->job_number;
+
+        // a worker that wakes up after the job has finished has nothing to do
+        Parallel_Job *job = pool->job;
+        if (job == NULL)
+            continue;
+
+        pool->active_count++;
+        pthread_mutex_unlock(&pool->lock);
+        run_parallel_tasks(job);
+        pthread_mutex_lock(&pool->lock);
+
+        if (--pool->active_count == 0)
+            pthread_cond_signal(&pool->job_left);
     }
 
-    return predicted_result;
+    return NULL;
 }
 
 /*
-Returns the best move based on the naive bayes prediction
+Starts the workers of the pool the first time run_parallel needs them, one less than the number of cores as the caller also runs tasks
+If a thread cannot be created, the pool runs with the workers that were started
 */
-Move get_naive_bayes_best_move()
+void start_parallel_pool()
 {
-    // initialize best score to a very low value
-    double best_score = -1000;
-    bool positive_move_found = false;
-    Move best_move = {-1, -1};
+    Parallel_Pool *pool = &g_parallel_pool;
 
-    // loop through the grid, if cell is empty, place tile and calculate the score
-    for (int i = 0; i < ROW; i++)
-    {
-        for (int j = 0; j < COLUMN; j++)
-        {
-            // if cell is empty, attempt move and see if it is the best move
-            if (g_grid[i][j] == EMPTY)
-            {
-                // temporarily set the cell with the current player's tile
-                g_grid[i][j] = g_player_two.tile;
-                // Get the predicted result of the current grid
-                Predicted_Result predicted_result = naive_bayes_predict(get_current_grid());
-                // undo the move (backtrack)
-                g_grid[i][j] = EMPTY;
+    for (int i = pool->thread_count; i < get_thread_count() - 1; i++)
+        if (pthread_create(&pool->threads[pool->thread_count], NULL, parallel_worker, pool) == 0)
+            pool->thread_count++;
+}
 
-                // Get the best move by comparing the score of each move, with positive prediction move having higher priority
-                if (predicted_result.result == POSITIVE || (predicted_result.result == NEGATIVE && !positive_move_found))
-                {
-                    if (predicted_result.result == POSITIVE)
-                        // if positive move is found, set positive_move_found to true, so that we will only take positive move
-                        positive_move_found = true;
+/*
+Runs task(0, context) to task(task_count - 1, context) on the pool of worker threads and waits for all of them to finish
+The calling thread is one of the workers. The pool runs one job at a time, so a call made while it is busy,
+such as from inside a task or from a second thread, runs its tasks on the calling thread instead of waiting
+*/
+void run_parallel(void (*task)(int task_index, void *context), int task_count, void *context)
+{
+    Parallel_Pool *pool = &g_parallel_pool;
+    Parallel_Job job = {task, context, task_count, 0};
 
-                    if (predicted_result.score > best_score)
-                    {
-                        // if the score is better than the current best score, update the best score and best move
-                        best_score = predicted_result.score;
-                        best_move.row = i;
-                        best_move.column = j;
-                    }
-                }
-            }
-        }
+    if (task_count <= 1 || get_thread_count() == 1 || pthread_mutex_trylock(&pool->busy) != 0)
+    {
+        run_parallel_tasks(&job);
+        return;
     }
 
-    return best_move;
+    if (pool->thread_count == 0)
+        start_parallel_pool();
+
+    pthread_mutex_lock(&pool->lock);
+    pool->job = &job;
+    pool->job_number++;
+    pthread_cond_broadcast(&pool->job_posted);
+    pthread_mutex_unlock(&pool->lock);
+
+    run_parallel_tasks(&job);
+
+    // every task has been taken once the caller runs out of tasks, wait for the workers to finish the ones they took
+    pthread_mutex_lock(&pool->lock);
+    while (pool->active_count > 0)
+        pthread_cond_wait(&pool->job_left, &pool->lock);
+    pool->job = NULL;
+    pthread_mutex_unlock(&pool->lock);
+
+    pthread_mutex_unlock(&pool->busy);
 }
 
 /*
-Returns the confusion matrix of the current dataset {TP, FP, TN, FN, probability_error, accuracy}
+Runs the headless tool that is requested by the command line arguments instead of the game
+Returns the exit code of the program
 */
-Confusion_Matrix calculate_confusion_matrix()
+int run_command_line_tool(int argc, char *argv[])
 {
-    int data_count = floor(g_dataset_count * (1 - TRAINING_DATA_WEIGHT));
-    // initialize confusion matrix
-    Confusion_Matrix confusion_matrix = {0, 0, 0, 0, 0, 0};
+    // --cross-validate [folds] [seed] [dataset file]
+    if (strcmp(argv[1], "--cross-validate") == 0)
+    {
+        int fold_count = argc > 2 ? atoi(argv[2]) : CROSS_VALIDATION_FOLDS;
+        unsigned int seed = argc > 3 ? strtoul(argv[3], NULL, 10) : 0;
 
-    // loop through the data and predict the result
-    for (int i = 0; i < data_count; i++)
+        read_ml_dataset(argc > 4 ? argv[4] : NB_DATASET_FILE);
+        run_cross_validation(fold_count, seed);
+        return 0;
+    }
+
+    // --sweep [seed] [dataset file]
+    if (strcmp(argv[1], "--sweep") == 0)
     {
-        // read the data from the end of the dataset_array up to 1 - TRAINING_DATA_WEIGHT % of the dataset
-        ML_Data_Row current_row = g_dataset_array[g_dataset_count - 1 - i];
-        Predicted_Result predicted_result = naive_bayes_predict(current_row);
+        unsigned int seed = argc > 2 ? strtoul(argv[2], NULL, 10) : 0;
 
-        if (predicted_result.result == current_row.result)
-        {
-            if (predicted_result.result == POSITIVE)
-                // predicted result is positive and actual result is positive
-                confusion_matrix.true_positive++;
-            else
-                // predicted result is negative and actual result is negative
-                confusion_matrix.true_negative++;
-        }
+        read_ml_dataset(argc > 3 ? argv[3] : NB_DATASET_FILE);
+        run_sweep(seed);
+        return 0;
+    }
+
+    // --roc [seed] [dataset file]
+    if (strcmp(argv[1], "--roc") == 0)
+    {
+        unsigned int seed = argc > 2 ? strtoul(argv[2], NULL, 10) : 0;
+
+        read_ml_dataset(argc > 3 ? argv[3] : NB_DATASET_FILE);
+        run_roc_evaluation(seed);
+        return 0;
+    }
+
+    // --preprocess <dedupe|augment|canonical> <output file> [dataset file]
+    if (strcmp(argv[1], "--preprocess") == 0 && argc > 3)
+    {
+        Preprocess_Mode mode;
+        if (strcmp(argv[2], "dedupe") == 0)
+            mode = PREPROCESS_DEDUPLICATE;
+        else if (strcmp(argv[2], "augment") == 0)
+            mode = PREPROCESS_AUGMENT;
+        else if (strcmp(argv[2], "canonical") == 0)
+            mode = PREPROCESS_CANONICAL;
         else
         {
-            if (predicted_result.result == POSITIVE)
-                // predicted result is positive and actual result is negative
-                confusion_matrix.false_positive++;
-            else
-                // predicted result is negative and actual result is positive
-                confusion_matrix.false_negative++;
+            printf("Unknown preprocess mode %s, expected dedupe, augment or canonical\n", argv[2]);
+            return 1;
         }
+
+        read_ml_dataset(argc > 4 ? argv[4] : NB_DATASET_FILE);
+        preprocess_ml_dataset(mode);
+        write_ml_dataset(argv[3]);
+        return 0;
     }
 
-    // divide the total count of each result by the total data count to get the probability
-    confusion_matrix.true_positive /= data_count;
-    confusion_matrix.true_negative /= data_count;
-    confusion_matrix.false_positive /= data_count;
-    confusion_matrix.false_negative /= data_count;
+    // --calibrate-mlp [seed] [dataset file]
+    if (strcmp(argv[1], "--calibrate-mlp") == 0)
+    {
+        unsigned int seed = argc > 2 ? strtoul(argv[2], NULL, 10) : 0;
 
-    // probability error is the sum of false positive and false negative, where the model makes a mistake
-    confusion_matrix.probability_error = confusion_matrix.false_positive + confusion_matrix.false_negative;
-    // accuracy is calculated as the number of all correct predictions divided by the total number of the datase
-    confusion_matrix.accuracy = (confusion_matrix.true_positive + confusion_matrix.true_negative) / (confusion_matrix.true_positive + confusion_matrix.true_negative + confusion_matrix.probability_error);
+        read_ml_dataset(argc > 3 ? argv[3] : NB_DATASET_FILE);
+        run_mlp_calibration(seed);
+        return 0;
+    }
 
-    return confusion_matrix;
-}
\ No newline at end of file
+    // --generate <board size> <output file> [samples] [seed]
+    if (strcmp(argv[1], "--generate") == 0 && argc > 3)
+    {
+        int sample_count = argc > 4 ? atoi(argv[4]) : 0;
+        unsigned long long seed = argc > 5 ? strtoull(argv[5], NULL, 10) : 0;
+
+        run_dataset_generator(atoi(argv[2]), argv[3], sample_count, seed);
+        return 0;
+    }
+
+    // --train-td <games> <output file> [seed]
+    if (strcmp(argv[1], "--train-td") == 0 && argc > 3)
+    {
+        unsigned long long seed = argc > 4 ? strtoull(argv[4], NULL, 10) : 0;
+
+        run_td_training(atoi(argv[2]), argv[3], seed);
+        return 0;
+    }
+
+    // --pack-resources [output header]
+    if (strcmp(argv[1], "--pack-resources") == 0)
+    {
+        write_resource_pack(argc > 2 ? argv[2] : RESOURCE_PACK_FILE);
+        return 0;
+    }
+
+    // --analysis-bench <board size> [frames]
+    if (strcmp(argv[1], "--analysis-bench") == 0 && argc > 2)
+    {
+        run_analysis_bench(atoi(argv[2]), argc > 3 ? atoi(argv[3]) : ANALYSIS_BENCH_FRAMES);
+        return 0;
+    }
+
+    // --replay-stats [replay file]
+    if (strcmp(argv[1], "--replay-stats") == 0)
+    {
+        run_replay_stats(argc > 2 ? argv[2] : REPLAY_FILE);
+        return 0;
+    }
+
+    printf("Usage: %s [--cross-validate [folds] [seed] [dataset file]]\n", argv[0]);
+    printf("       %s [--sweep [seed] [dataset file]]\n", argv[0]);
+    printf("       %s [--roc [seed] [dataset file]]\n", argv[0]);
+    printf("       %s [--preprocess <dedupe|augment|canonical> <output file> [dataset file]]\n", argv[0]);
+    printf("       %s [--calibrate-mlp [seed] [dataset file]]\n", argv[0]);
+    printf("       %s [--generate <board size> <output file> [samples] [seed]]\n", argv[0]);
+    printf("       %s [--train-td <games> <output file> [seed]]\n", argv[0]);
+    printf("       %s [--pack-resources [output header]]\n", argv[0]);
+    printf("       %s [--replay-stats [replay file]]\n", argv[0]);
+    printf("       %s [--analysis-bench <board size> [frames]]\n", argv[0]);
+    return 1;
+}